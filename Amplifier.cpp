@@ -16,4 +16,5 @@ AmplifierConfig amp_config(0.0f, 1.0f);
 EnvelopeConfig amp_env_config(false, 0.0f, 1.0f, 1.0f, 0.1f);
 
 // amplifier envelope state
-EnvelopeState amp_env_state[VOICES];
+// (allocated from the voice pool)
+EnvelopeState *amp_env_state;
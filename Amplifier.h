@@ -21,7 +21,7 @@ public:
 	}
 
 	// get the modulated level value
-	float GetLevel(float const env, float const vel)
+	float GetLevel(float const env, float const vel) const
 	{
 		return env * (level_env + vel * level_env_vel);
 	}
@@ -34,4 +34,4 @@ extern AmplifierConfig amp_config;
 extern EnvelopeConfig amp_env_config;
 
 // amplifier envelope state
-extern EnvelopeState amp_env_state[];
+extern EnvelopeState *amp_env_state;
@@ -14,8 +14,12 @@ Per-Key Volume Envelope Display
 #include "Voice.h"
 #include "Amplifier.h"
 
+// voice indicators shown
+// (with more voices, each indicator covers every DISPLAY_VOICES-th voice)
+#define DISPLAY_VOICES 16
+
 static COORD const key_pos = { 12, SPECTRUM_HEIGHT };
-static COORD const voice_pos = { WINDOW_WIDTH - 7 - VOICES, WINDOW_HEIGHT - 1 };
+static COORD const voice_pos = { WINDOW_WIDTH - 7 - DISPLAY_VOICES, WINDOW_HEIGHT - 1 };
 
 // attribute associated with each envelope state
 static WORD const env_attrib[EnvelopeState::COUNT] =
@@ -35,19 +39,21 @@ void DisplayKeyVolumeEnvelope::Init(HANDLE hOut)
 	FillConsoleOutputAttribute(hOut, env_attrib[EnvelopeState::OFF], KEYS, key_pos, &written);
 
 	// voice indicators
-	CHAR voice[VOICES];
-	memset(voice, 7, VOICES);
-	WriteConsoleOutputCharacter(hOut, voice, VOICES, voice_pos, &written);
+	CHAR voice[DISPLAY_VOICES];
+	memset(voice, 7, DISPLAY_VOICES);
+	WriteConsoleOutputCharacter(hOut, voice, DISPLAY_VOICES, voice_pos, &written);
 }
 
 
 void DisplayKeyVolumeEnvelope::Update(HANDLE hOut)
 {
 	WORD note_env_attrib[SPECTRUM_WIDTH];
-	WORD voice_env_attrib[VOICES];
+	WORD voice_env_attrib[DISPLAY_VOICES];
 
 	memset(note_env_attrib, env_attrib[EnvelopeState::OFF], sizeof(note_env_attrib));
-	for (int v = 0; v < VOICES; ++v)
+	for (int i = 0; i < DISPLAY_VOICES; ++i)
+		voice_env_attrib[i] = env_attrib[EnvelopeState::OFF];
+	for (int v = 0; v < voice_count; ++v)
 	{
 		EnvelopeState::State const state = amp_env_state[v].state;
 		WORD const attrib = env_attrib[state];
@@ -56,11 +62,11 @@ void DisplayKeyVolumeEnvelope::Update(HANDLE hOut)
 			int const x = key_pos.X - keyboard_octave * 12 + voice_note[v];
 			if (x >= 0 && x < SPECTRUM_WIDTH)
 				note_env_attrib[x] = attrib;
+			voice_env_attrib[v % DISPLAY_VOICES] = attrib;
 		}
-		voice_env_attrib[v] = attrib;
 	}
 
 	DWORD written;
 	WriteConsoleOutputAttribute(hOut, note_env_attrib, SPECTRUM_WIDTH, { 0, key_pos.Y }, &written);
-	WriteConsoleOutputAttribute(hOut, voice_env_attrib, VOICES, voice_pos, &written);
+	WriteConsoleOutputAttribute(hOut, voice_env_attrib, DISPLAY_VOICES, voice_pos, &written);
 }
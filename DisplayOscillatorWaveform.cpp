@@ -168,7 +168,7 @@ void DisplayOscillatorWaveform::Update(HANDLE hOut, BASS_INFO const &info, int c
 
 		// set up the filter
 		// (assume it is constant for the duration)
-		filter.Setup(cutoff / osc1_freq, flt_config.resonance, step_base);
+		filter.Setup(flt_config, cutoff / osc1_freq, flt_config.resonance, step_base);
 
 		// compute the number of cycles since last frame
 		float totalCycles = osc1_freq * deltaTime / 1000 + cyclesLeftOver;
@@ -63,6 +63,29 @@ void EnvelopeState::Gate(EnvelopeConfig const &config, bool on)
 	}
 }
 
+// turn off envelope generator
+void EnvelopeState::Stop()
+{
+	gate = false;
+	state = OFF;
+	amplitude = 0.0f;
+}
+
+// check if the envelope generator is falling
+bool EnvelopeState::IsFalling(EnvelopeConfig const &config) const
+{
+	switch (state)
+	{
+	case DECAY:
+	case SUSTAIN:
+		return config.sustain_level <= 0.0f;
+	case RELEASE:
+		return true;
+	default:
+		return false;
+	}
+}
+
 // update envelope generator
 float EnvelopeState::Update(EnvelopeConfig const &config, float const step)
 {
@@ -116,3 +139,147 @@ float EnvelopeState::Update(EnvelopeConfig const &config, float const step)
 
 	return amplitude;
 }
+
+// get envelope generator segment
+// (matches the per-state behavior of Update)
+size_t EnvelopeState::GetSegment(EnvelopeConfig const &config, float const step, size_t const count, float &target, float &decay, float &limit) const
+{
+	float rate;
+	switch (state)
+	{
+	case ATTACK:
+		target = 1.0f + ENV_ATTACK_BIAS;
+		rate = config.attack_rate;
+		limit = 1.0f;
+		break;
+
+	case DECAY:
+		target = config.sustain_level + (1.0f - config.sustain_level) * ENV_DECAY_BIAS;
+		rate = config.decay_rate;
+		limit = config.sustain_level;
+		break;
+
+	case RELEASE:
+		target = ENV_DECAY_BIAS;
+		if (amplitude <= config.sustain_level || config.decay_rate < config.release_rate)
+		{
+			rate = config.release_rate;
+			limit = 0.0f;
+		}
+		else
+		{
+			rate = config.decay_rate;
+			limit = config.sustain_level;
+		}
+		break;
+
+	default:
+		// hold the current amplitude
+		target = amplitude;
+		decay = 0.0f;
+		limit = amplitude;
+		return count + 1;
+	}
+
+	// amplitude += (target - amplitude) * rate * step
+	// (amplitude - target) -= (amplitude - target) * decay
+	// (decay stays separate from 1 - decay, which would round away its precision)
+	decay = rate * step;
+	double const factor = 1.0 - double(decay);
+
+	// a step this large lands on or past the target, which lies beyond the limit
+	if (factor <= 0.0)
+		return 1;
+
+	// the amplitude is already at the limit or past it
+	// (tested without dividing, since the target may equal the limit;
+	// fast math cannot be trusted to catch the resulting NaN)
+	if ((amplitude - limit) * (amplitude - target) <= 0.0f)
+		return 1;
+
+	// solve target + (amplitude - target) * factor^n = limit for n
+	double const ratio = double(limit - target) / double(amplitude - target);
+	if (ratio <= 0.0 || factor >= 1.0)
+		return count + 1;
+
+	// skip the logarithms while the limit is out of reach
+	// (each sample moves the amplitude by at most decay times the starting distance)
+	if (1.0 - ratio > double(decay) * double(count))
+		return count + 1;
+	double const n = ceil(log(ratio) / log(factor));
+	return n > double(count) ? count + 1 : Max(size_t(n), size_t(1));
+}
+
+// end envelope generator segment
+void EnvelopeState::EndSegment(EnvelopeConfig const &config, float const limit)
+{
+	amplitude = limit;
+	switch (state)
+	{
+	case ATTACK:
+		if (config.sustain_level < 1.0f)
+			state = DECAY;
+		else
+			state = SUSTAIN;
+		break;
+
+	case DECAY:
+		state = SUSTAIN;
+		break;
+
+	case RELEASE:
+		if (amplitude <= 0.0f)
+		{
+			amplitude = 0.0f;
+			state = OFF;
+		}
+		break;
+	}
+}
+
+// render envelope generator
+// (fills each segment from its closed form up to the sample that ends it)
+size_t EnvelopeState::Render(EnvelopeConfig const &config, float const step, float buffer[], size_t const count)
+{
+	if (state == OFF)
+		return 0;
+
+	// a disabled envelope generator follows the gate
+	if (!config.enable)
+	{
+		for (size_t i = 0; i < count; ++i)
+			buffer[i] = gate;
+		return count;
+	}
+
+	size_t i = 0;
+	while (i < count)
+	{
+		float target, decay, limit;
+		size_t const length = GetSegment(config, step, count - i, target, decay, limit);
+
+		// samples inside the segment
+		// (held short of the limit in case rounding reaches it a sample early)
+		size_t const run = length - 1;
+		float const lower = Min(limit, amplitude);
+		float const upper = Max(limit, amplitude);
+		float delta = amplitude - target;
+		for (size_t end = i + run; i < end; ++i)
+		{
+			delta -= delta * decay;
+			buffer[i] = Clamp(target + delta, lower, upper);
+		}
+		if (run > 0)
+			amplitude = buffer[i - 1];
+		if (i >= count)
+			break;
+
+		// the next sample reaches the limit
+		EndSegment(config, limit);
+		buffer[i] = amplitude;
+		if (state == OFF)
+			return i;
+		++i;
+	}
+	return count;
+}
@@ -45,5 +45,25 @@ public:
 
 	void Gate(EnvelopeConfig const &config, bool on);
 
+	// turn off immediately
+	void Stop();
+
+	// check if the amplitude can only fall from here
+	// (releasing, or decaying toward a zero sustain level)
+	bool IsFalling(EnvelopeConfig const &config) const;
+
 	float Update(EnvelopeConfig const &config, float const step);
+
+	// render a block of envelope amplitudes
+	// (returns the number of samples rendered before the envelope turned off)
+	size_t Render(EnvelopeConfig const &config, float const step, float buffer[], size_t const count);
+
+	// get the current envelope segment in closed form
+	// (after n samples, amplitude is target + (amplitude - target) * (1 - decay)^n;
+	// returns the sample, counting from 1, that reaches the limit and ends the segment,
+	// or count + 1 if that is past count samples)
+	size_t GetSegment(EnvelopeConfig const &config, float const step, size_t const count, float &target, float &decay, float &limit) const;
+
+	// finish the current envelope segment at the given limit
+	void EndSegment(EnvelopeConfig const &config, float const limit);
 };
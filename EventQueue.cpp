@@ -0,0 +1,180 @@
+/*
+MINI VIRTUAL ANALOG SYNTHESIZER
+Copyright 2014 Kenneth D. Miller III
+
+Event Queue
+*/
+#include "StdAfx.h"
+
+#include <atomic>
+
+#include "EventQueue.h"
+#include "Math.h"
+#include "Voice.h"
+#include "Control.h"
+#include "Amplifier.h"
+
+namespace EventQueue
+{
+	// queued channel message
+	struct Event
+	{
+		unsigned int time;
+		unsigned char status;
+		unsigned char data1;
+		unsigned char data2;
+	};
+
+	// single-producer/single-consumer ring
+	// (the producer only writes tail and the consumer only writes head, each
+	// on its own cache line so the two threads do not contend)
+	struct Ring
+	{
+		std::atomic<unsigned int> tail;
+		char pad0[64 - sizeof(std::atomic<unsigned int>)];
+		std::atomic<unsigned int> head;
+		char pad1[64 - sizeof(std::atomic<unsigned int>)];
+		Event event[CAPACITY];
+	};
+	static Ring ring[SOURCE_COUNT];
+
+	// time span covered by the buffer being rendered
+	// (from the previous buffer request to the latest one)
+	static bool clocked;
+	static unsigned int time_begin;
+	static unsigned int time_end;
+
+	// collected message placed within the buffer
+	struct Placed
+	{
+		size_t offset;
+		Event event;
+	};
+
+	// collected messages in offset order
+	static Placed placed[SOURCE_COUNT * CAPACITY];
+	static int placed_count;
+	static int placed_next;
+
+	// queue a channel message from a source
+	bool Push(Source const source, unsigned int const time, unsigned char const status, unsigned char const data1, unsigned char const data2)
+	{
+		Ring &r = ring[source];
+		unsigned int const tail = r.tail.load(std::memory_order_relaxed);
+		if (tail - r.head.load(std::memory_order_acquire) >= CAPACITY)
+			return false;
+		Event &event = r.event[tail & (CAPACITY - 1)];
+		event.time = time;
+		event.status = status;
+		event.data1 = data1;
+		event.data2 = data2;
+		r.tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// mark the time of an output buffer request
+	void SetTime(unsigned int const time)
+	{
+		time_begin = clocked ? time_end : time;
+		time_end = time;
+		clocked = true;
+	}
+
+	// take messages and place them within the buffer
+	void Collect(size_t const count)
+	{
+		placed_count = 0;
+		placed_next = 0;
+
+		// length of the time span
+		// (without a clock, everything lands at the start of the buffer)
+		unsigned int const span = time_end - time_begin;
+
+		for (int s = 0; s < SOURCE_COUNT; ++s)
+		{
+			Ring &r = ring[s];
+			unsigned int head = r.head.load(std::memory_order_relaxed);
+			unsigned int const tail = r.tail.load(std::memory_order_acquire);
+			for (; head != tail; ++head)
+			{
+				Event const &event = r.event[head & (CAPACITY - 1)];
+
+				// position within the span
+				size_t offset = 0;
+				if (clocked)
+				{
+					// messages stamped after the latest request wait for the next buffer
+					if (int(event.time - time_end) > 0)
+						break;
+					int const delta = int(event.time - time_begin);
+					if (delta > 0)
+						offset = Min(size_t(delta) * count / span, count - 1);
+				}
+
+				// insert in offset order after messages at the same offset
+				int i = placed_count++;
+				for (; i > 0 && placed[i - 1].offset > offset; --i)
+					placed[i] = placed[i - 1];
+				placed[i].offset = offset;
+				placed[i].event = event;
+			}
+			r.head.store(head, std::memory_order_release);
+		}
+	}
+
+	// apply collected messages placed at or before a sample offset
+	size_t Dispatch(size_t const offset)
+	{
+		for (; placed_next < placed_count; ++placed_next)
+		{
+			Placed const &p = placed[placed_next];
+			if (p.offset > offset)
+				return p.offset;
+			Apply(p.event.status, p.event.data1, p.event.data2);
+		}
+		return NONE;
+	}
+
+	// apply a channel message
+	void Apply(unsigned char const status, unsigned char const data1, unsigned char const data2)
+	{
+		switch (status & 0xF0)
+		{
+		case 0x80:
+			NoteOff(data1, data2);
+			break;
+		case 0x90:
+			if (data2)
+				NoteOn(data1, data2);
+			else
+				NoteOff(data1);
+			break;
+		case 0xB0:
+			if (data1 == 120)
+			{
+				// all sound off
+				for (int v = 0; v < voice_count; ++v)
+				{
+					NoteOff(voice_note[v], 0);
+					amp_env_state[v].amplitude = 0;
+					amp_env_state[v].state = EnvelopeState::OFF;
+				}
+			}
+			else if (data1 == 121)
+			{
+				// reset all controllers
+				Control::ResetAll();
+			}
+			else if (data1 == 123)
+			{
+				// all notes off
+				for (int v = 0; v < voice_count; ++v)
+					NoteOff(voice_note[v], 0);
+			}
+			break;
+		case 0xE0:
+			Control::SetPitchWheel((data2 << 7) + data1 - 0x2000);
+			break;
+		}
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+/*
+MINI VIRTUAL ANALOG SYNTHESIZER
+Copyright 2014 Kenneth D. Miller III
+
+Event Queue
+*/
+
+// Front ends (MIDI input and the computer keyboard) never touch voice state
+// directly.  Each one pushes time-stamped channel messages into its own wait-
+// free single-producer/single-consumer ring, so every voice mutation happens
+// on the render thread.
+//
+// Time stamps are in milliseconds on the system timer.  The audio stream
+// marks the time of each buffer request with SetTime, and messages that
+// arrived since the previous request are spread over the new buffer at the
+// same relative positions.  This delays every message by one buffer period
+// but keeps the spacing between messages, instead of snapping each one to
+// whatever buffer boundary happens to come next.
+
+namespace EventQueue
+{
+	// event sources
+	// (each source must push from only one thread)
+	enum Source
+	{
+		SOURCE_MIDI,
+		SOURCE_KEYBOARD,
+
+		SOURCE_COUNT
+	};
+
+	// events per source ring
+	// (must be a power of two)
+	static unsigned int const CAPACITY = 256;
+
+	// no message pending
+	static size_t const NONE = ~size_t(0);
+
+	// queue a channel message from a source
+	// (returns false if the ring is full and the message was dropped)
+	extern bool Push(Source const source, unsigned int const time, unsigned char const status, unsigned char const data1, unsigned char const data2);
+
+	// mark the time of an output buffer request
+	// (render thread only)
+	extern void SetTime(unsigned int const time);
+
+	// take the messages that arrived before the last buffer request and place
+	// them within a buffer of count samples
+	// (render thread only)
+	extern void Collect(size_t const count);
+
+	// apply collected messages placed at or before a sample offset
+	// (render thread only; returns the offset of the next message or NONE)
+	extern size_t Dispatch(size_t const offset);
+
+	// apply a channel message immediately
+	// (render thread only, or while nothing is rendering)
+	extern void Apply(unsigned char const status, unsigned char const data1, unsigned char const data2);
+}
@@ -37,13 +37,32 @@ float CubicSaturate(float const x)
 //#define Saturate(x) tanhf(x)
 
 // filter configuration
-FilterConfig flt_config(false, FilterConfig::LOWPASS_4, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+FilterConfig flt_config(false, FILTER_TPT_MOOG, FilterConfig::LOWPASS_4, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
 
 // filter envelope config
 EnvelopeConfig flt_env_config(false, 0.0f, 1.0f, 0.0f, 0.1f);
 
 // filter envelope state
-EnvelopeState flt_env_state[VOICES];
+// (allocated from the voice pool)
+EnvelopeState *flt_env_state;
+
+// filter model names
+char const * const filter_model_name[FILTER_MODEL_COUNT] =
+{
+	"Improved Moog",
+	"Linear Moog",
+	"Nonlinear Moog",
+	"TPT Moog",
+};
+
+// default oversampling factor for each filter model
+int const filter_oversample[FILTER_MODEL_COUNT] =
+{
+	2,	// FILTER_IMPROVED_MOOG
+	2,	// FILTER_LINEAR_MOOG
+	2,	// FILTER_NONLINEAR_MOOG
+	1,	// FILTER_TPT_MOOG
+};
 
 // filter mode names
 char const * const filter_name[FilterConfig::COUNT] =
@@ -180,28 +199,26 @@ static float const filter_mix[FilterConfig::COUNT][5] =
 };
 
 // filter state
-FilterState flt_state[VOICES];
+// (allocated from the voice pool)
+FilterState *flt_state;
 
 // reset filter state
 void FilterState::Reset()
 {
 	feedback = 0.0f;
-#if FILTER == FILTER_IMPROVED_MOOG
 	a1 = 0.0f; b0 = 0.0f; b1 = 0.0f;
-#elif FILTER == FILTER_LINEAR_MOOG
-	previous = 0.0f;
-	delayed = 0.0f;
-	tune = 0.0f;
-#elif FILTER == FILTER_NONLINEAR_MOOG
 	previous = 0.0f;
 	delayed = 0.0f;
 	tune = 0.0f;
-	memset(z, 0, sizeof(z));
-#elif FILTER == FILTER_TPT_MOOG
 	inv1g = 0; G = 0; alpha0 = 0;
 	memset(z, 0, sizeof(z));
-#endif
 	memset(y, 0, sizeof(y));
+	feedback_step = 0.0f;
+	tune_step = 0.0f;
+	a1_step = 0.0f; b0_step = 0.0f; b1_step = 0.0f;
+	G_step = 0.0f; inv1g_step = 0.0f; alpha0_step = 0.0f;
+	primed = false;
+	oversampler.Reset();
 }
 
 // set filter mode
@@ -209,57 +226,56 @@ void FilterConfig::SetMode(FilterConfig::Mode newmode)
 {
 	mode = newmode;
 	memcpy(mix, filter_mix[mode], sizeof(mix));
+
+	// find the last stage with a nonzero weight
+	// (always at least one so the filter keeps some state)
+	stages = 4;
+	while (stages > 1 && mix[stages] == 0.0f)
+		--stages;
 }
 
-// compute filter values based on cutoff frequency and resonance
-void FilterState::Setup(float const cutoff, float const resonance, float const step)
+// cutoff-dependent filter coefficients
+struct FilterTuning
 {
-	//float const fn = FILTER_OVERSAMPLE * 0.5f * info.freq;
-	//float const fc = cutoff < fn ? cutoff / fn : 1.0f;
-	float const fc = cutoff * step * 2.0f / FILTER_OVERSAMPLE;
-
-#if FILTER == FILTER_IMPROVED_MOOG
-
-	// Based on Improved Moog Filter description
-	// http://www.music.mcgill.ca/~ich/research/misc/papers/cr1071.pdf
+	// FILTER_IMPROVED_MOOG: stage coefficient
+	float g;
 
-	float const g = 1 - expf(-M_PI * fc);
-	feedback = 4.0f * resonance;
-	// y[n] = ((1.0 / 1.3) * x[n] + (0.3 / 1.3) * x[n-1] - y[n-1]) * g + y[n-1]
-	// y[n] = (g / 1.3) * x[n] + (g * 0.3 / 1.3) * x[n-1] - (g - 1) * y[n-1]
-	a1 = 1.0f - g; b0 = g * 0.769231f; b1 = b0 * 0.3f;
+	// FILTER_LINEAR_MOOG and FILTER_NONLINEAR_MOOG: tuning and resonance compensation
+	float tune;
+	float acr;
 
-#elif FILTER == FILTER_LINEAR_MOOG
-
-	// Linear version of Antti Huovilainen's digital implementation
-	// http://www.acoustics.ed.ac.uk/wp-content/uploads/AMT_MSc_FinalProjects/2012__Daly__AMT_MSc_FinalProject_MoogVCF.pdf
+	// FILTER_TPT_MOOG: 1 / (1 + g)
+	float inv1g;
+};
 
-	// this part is more expensive than the Improved Moog but the filter itself is cheaper
-	float const fcr = ((1.8730f * fc + 0.4955f) * fc + -0.6490f) * fc + 0.9988f;
-	float const acr = (-3.9364f * fc + 1.8409f) * fc + 0.9968f;
-	feedback = resonance * 4.0f * acr;
-	tune = 1.0f - expf(-M_PI * fc * fcr);
+// filter tuning table range and resolution
+// (indexed by the base-2 logarithm of the normalized cutoff frequency)
+#define FILTER_TUNING_LOG2_MIN -16
+#define FILTER_TUNING_LOG2_MAX 2
+#define FILTER_TUNING_STEPS 32
+#define FILTER_TUNING_SIZE ((FILTER_TUNING_LOG2_MAX - FILTER_TUNING_LOG2_MIN) * FILTER_TUNING_STEPS + 1)
 
-#elif FILTER == FILTER_NONLINEAR_MOOG
+// filter tuning table
+static FilterTuning filter_tuning[FILTER_TUNING_SIZE];
 
-	// Based on Antti Huovilainen's non-linear digital implementation
-	// http://dafx04.na.infn.it/WebProc/Proc/P_061.pdf
-	// https://raw.github.com/ddiakopoulos/MoogLadders/master/Source/Huovilainen.cpp
-	// 0 <= resonance <= 1
+// compute filter coefficients for a normalized cutoff frequency
+// (1.0 is the Nyquist frequency)
+static void ComputeTuning(float const fc, FilterTuning &tuning)
+{
+	// Based on Improved Moog Filter description
+	// http://www.music.mcgill.ca/~ich/research/misc/papers/cr1071.pdf
+	tuning.g = 1 - expf(-M_PI * fc);
 
+	// Antti Huovilainen's digital implementation
+	// http://www.acoustics.ed.ac.uk/wp-content/uploads/AMT_MSc_FinalProjects/2012__Daly__AMT_MSc_FinalProject_MoogVCF.pdf
 	float const fcr = ((1.8730f * fc + 0.4955f) * fc + -0.6490f) * fc + 0.9988f;
-	float const acr = (-3.9364f * fc + 1.8409f) * fc + 0.9968f;
-	feedback = resonance * 4.0f * acr;
-	tune = (1.0f - expf(-M_PI * fc * fcr)) * 1.22070313f;
-
-#elif FILTER == FILTER_TPT_MOOG
+	tuning.acr = (-3.9364f * fc + 1.8409f) * fc + 0.9968f;
+	tuning.tune = 1.0f - expf(-M_PI * fc * fcr);
 
 	// Based on Will Pirkle's implementation of Vadim Zavalishin's
 	// Topology-Preserving Transform (TPT) virtual analog ladder filter
 	// http://www.native-instruments.com/fileadmin/ni_media/downloads/pdf/VAFilterDesign_1.0.3.pdf
 	// http://www.willpirkle.com/Downloads/AN-4VirtualAnalogFilters.2.0.pdf
-
-	feedback = resonance * 4.0f;
 	if (fc < 0.5f)
 	{
 		float const f = 0.5f * M_PI * fc;
@@ -270,40 +286,142 @@ void FilterState::Setup(float const cutoff, float const resonance, float const s
 		float const ff = f * f;
 		//float const g = f * (1 + ff * (0.3333314036f + ff * (0.1333923995f + ff * (0.0533740603f + ff * (0.0245650893f + ff * (0.002900525f + ff * 0.0095168091f))))));
 		float const g = f * (1 + ff * (0.31755f + ff * 0.2033f));
-		inv1g = 1 / (1 + g);
+		tuning.inv1g = 1 / (1 + g);
 	}
 	else if (fc < 1.0f)
 	{
 		// use the identity 1 / tan(0.5 pi (1 - fc)) = tan(0.5 pi fc)
-        // accurate for fc in the range [0.5,1.0]
+		// accurate for fc in the range [0.5,1.0]
 		float const f = 0.5f * M_PI * (1 - fc);
 		float const ff = f * f;
 		float const invg = f * (1 + ff * (0.31755f + ff * 0.2033f));
 		// 1/(1+1/g) = g/(g+1) = 1-(1/(g+1))
-		inv1g = 1 - 1 / (1 + invg);
+		tuning.inv1g = 1 - 1 / (1 + invg);
 	}
 	else
 	{
 		// 1/(1+infinity) = 0
-		inv1g = 0;
+		tuning.inv1g = 0;
 	}
-	// g/(1+g) = 1-(1/(1+g))
-	G = 1 - inv1g;
-	alpha0 = 1 / (1 + feedback * G * G * G * G);
-#endif
 }
 
-// update the filter
-float FilterState::Update(FilterConfig const &config, float const input)
+// build the filter tuning table
+void InitFilter()
+{
+	for (int i = 0; i < FILTER_TUNING_SIZE; ++i)
+		ComputeTuning(powf(2.0f, FILTER_TUNING_LOG2_MIN + float(i) / FILTER_TUNING_STEPS), filter_tuning[i]);
+}
+
+// look up filter coefficients for a normalized cutoff frequency
+// (interpolates linearly in log-cutoff; clamps outside the table)
+static __forceinline FilterTuning GetTuning(float const fc)
+{
+	float const x = Clamp((FastLog2(fc) - FILTER_TUNING_LOG2_MIN) * FILTER_TUNING_STEPS, 0.0f, float(FILTER_TUNING_SIZE - 1));
+	int const i = Min(FloorInt(x), FILTER_TUNING_SIZE - 2);
+	float const f = x - float(i);
+	FilterTuning const &t0 = filter_tuning[i];
+	FilterTuning const &t1 = filter_tuning[i + 1];
+	FilterTuning tuning;
+	tuning.g = t0.g + (t1.g - t0.g) * f;
+	tuning.tune = t0.tune + (t1.tune - t0.tune) * f;
+	tuning.acr = t0.acr + (t1.acr - t0.acr) * f;
+	tuning.inv1g = t0.inv1g + (t1.inv1g - t0.inv1g) * f;
+	return tuning;
+}
+
+// compute filter values based on cutoff frequency and resonance
+template <FilterModel MODEL> void FilterState::Setup(float const cutoff, float const resonance, float const step)
+{
+	//float const fn = 0.5f * info.freq;
+	//float const fc = cutoff < fn ? cutoff / fn : 1.0f;
+	float const fc = cutoff * step * 2.0f;
+	FilterTuning const tuning = GetTuning(fc);
+
+	if (MODEL == FILTER_IMPROVED_MOOG)
+	{
+		float const g = tuning.g;
+		feedback = 4.0f * resonance;
+		// y[n] = ((1.0 / 1.3) * x[n] + (0.3 / 1.3) * x[n-1] - y[n-1]) * g + y[n-1]
+		// y[n] = (g / 1.3) * x[n] + (g * 0.3 / 1.3) * x[n-1] - (g - 1) * y[n-1]
+		a1 = 1.0f - g; b0 = g * 0.769231f; b1 = b0 * 0.3f;
+	}
+	else if (MODEL == FILTER_LINEAR_MOOG)
+	{
+		feedback = resonance * 4.0f * tuning.acr;
+		tune = tuning.tune;
+	}
+	else if (MODEL == FILTER_NONLINEAR_MOOG)
+	{
+		// Based on Antti Huovilainen's non-linear digital implementation
+		// http://dafx04.na.infn.it/WebProc/Proc/P_061.pdf
+		// https://raw.github.com/ddiakopoulos/MoogLadders/master/Source/Huovilainen.cpp
+		// 0 <= resonance <= 1
+		feedback = resonance * 4.0f * tuning.acr;
+		tune = tuning.tune * 1.22070313f;
+	}
+	else if (MODEL == FILTER_TPT_MOOG)
+	{
+		feedback = resonance * 4.0f;
+		inv1g = tuning.inv1g;
+		// g/(1+g) = 1-(1/(1+g))
+		G = 1 - inv1g;
+		alpha0 = 1 / (1 + feedback * G * G * G * G);
+	}
+}
+
+// ramp filter values to a new cutoff frequency and resonance
+template <FilterModel MODEL> void FilterState::Ramp(float const cutoff, float const resonance, float const step, size_t const count)
+{
+	// values at the start of the ramp
+	float const from_feedback = feedback;
+	float const from_tune = tune;
+	float const from_a1 = a1, from_b0 = b0, from_b1 = b1;
+	float const from_G = G, from_inv1g = inv1g, from_alpha0 = alpha0;
+
+	// values at the end of the ramp
+	Setup<MODEL>(cutoff, resonance, step);
+
+	// jump to the end if there is nothing to ramp from
+	if (!primed || count == 0)
+	{
+		feedback_step = 0.0f;
+		tune_step = 0.0f;
+		a1_step = 0.0f; b0_step = 0.0f; b1_step = 0.0f;
+		G_step = 0.0f; inv1g_step = 0.0f; alpha0_step = 0.0f;
+		primed = true;
+		return;
+	}
+
+	// step each value once per sample
+	// (Render applies the step before filtering each sample)
+	float const scale = 1.0f / count;
+	feedback_step = (feedback - from_feedback) * scale;
+	feedback = from_feedback;
+	if (MODEL == FILTER_IMPROVED_MOOG)
+	{
+		a1_step = (a1 - from_a1) * scale; a1 = from_a1;
+		b0_step = (b0 - from_b0) * scale; b0 = from_b0;
+		b1_step = (b1 - from_b1) * scale; b1 = from_b1;
+	}
+	else if (MODEL == FILTER_LINEAR_MOOG || MODEL == FILTER_NONLINEAR_MOOG)
+	{
+		tune_step = (tune - from_tune) * scale; tune = from_tune;
+	}
+	else if (MODEL == FILTER_TPT_MOOG)
+	{
+		G_step = (G - from_G) * scale; G = from_G;
+		inv1g_step = (inv1g - from_inv1g) * scale; inv1g = from_inv1g;
+		alpha0_step = (alpha0 - from_alpha0) * scale; alpha0 = from_alpha0;
+	}
+}
+
+// advance the filter by one oversampled step
+template <FilterModel MODEL, int STAGES> __forceinline void FilterState::Step(FilterConfig const &config, float const input)
 {
 	// input with drive and gain compensation
 	float const input_adjusted = input * config.drive * (1.0f + feedback * config.compensation);
 
-#if FILTER == FILTER_IMPROVED_MOOG
-
-#if FILTER_OVERSAMPLE > 1
-	for (int i = 0; i < FILTER_OVERSAMPLE; ++i)
-#endif
+	if (MODEL == FILTER_IMPROVED_MOOG)
 	{
 		// nonlinear feedback with gain compensation
 #if SATURATE == SATURATE_INPUT
@@ -333,16 +451,14 @@ float FilterState::Update(FilterConfig const &config, float const input)
 		float const t[4] = { y[0], y[1], y[2], y[3] };
 		y[0] = in;
 		y[1] = y[1] * a1 + y[0] * b0 + t[0] * b1;
-		y[2] = y[2] * a1 + y[1] * b0 + t[1] * b1;
-		y[3] = y[3] * a1 + y[2] * b0 + t[2] * b1;
-		y[4] = y[4] * a1 + y[3] * b0 + t[3] * b1;
+		if (STAGES > 1)
+			y[2] = y[2] * a1 + y[1] * b0 + t[1] * b1;
+		if (STAGES > 2)
+			y[3] = y[3] * a1 + y[2] * b0 + t[2] * b1;
+		if (STAGES > 3)
+			y[4] = y[4] * a1 + y[3] * b0 + t[3] * b1;
 	}
-
-#elif FILTER == FILTER_LINEAR_MOOG
-
-#if FILTER_OVERSAMPLE > 1
-	for (int i = 0; i < FILTER_OVERSAMPLE; ++i)
-#endif
+	else if (MODEL == FILTER_LINEAR_MOOG)
 	{
 		// half-sample delay for phase compensation
 		delayed = 0.5f * (y[4] + previous);
@@ -357,19 +473,17 @@ float FilterState::Update(FilterConfig const &config, float const input)
 
 		// four-pole low-pass filter
 		y[1] += tune * (y[0] - y[1]);
-		y[2] += tune * (y[1] - y[2]);
-		y[3] += tune * (y[2] - y[3]);
-		y[4] += tune * (y[3] - y[4]);
+		if (STAGES > 1)
+			y[2] += tune * (y[1] - y[2]);
+		if (STAGES > 2)
+			y[3] += tune * (y[2] - y[3]);
+		if (STAGES > 3)
+			y[4] += tune * (y[3] - y[4]);
 	}
-
-#elif FILTER == FILTER_NONLINEAR_MOOG
-
-	// modified original algorithm based on sample code here:
-	// http://www.kvraudio.com/forum/viewtopic.php?p=3821632
-#if FILTER_OVERSAMPLE > 1
-	for (int i = 0; i < FILTER_OVERSAMPLE; ++i)
-#endif
+	else if (MODEL == FILTER_NONLINEAR_MOOG)
 	{
+		// modified original algorithm based on sample code here:
+		// http://www.kvraudio.com/forum/viewtopic.php?p=3821632
 		// half-sample delay for phase compensation
 		delayed = 0.5f * (y[4] + previous);
 		previous = y[4];
@@ -381,46 +495,210 @@ float FilterState::Update(FilterConfig const &config, float const input)
 		// nonlinear four-pole low-pass filter
 		y[1] += tune * (z[0] - z[1]);
 		z[1] = FastTanh(y[1] * 0.8192f);
-		y[2] += tune * (z[1] - z[2]);
-		z[2] = FastTanh(y[2] * 0.8192f);
-		y[3] += tune * (z[2] - z[3]);
-		z[3] = FastTanh(y[3] * 0.8192f);
-		y[4] += tune * (z[3] - z[4]);
-		z[4] = FastTanh(y[4] * 0.8192f);
+		if (STAGES > 1)
+		{
+			y[2] += tune * (z[1] - z[2]);
+			z[2] = FastTanh(y[2] * 0.8192f);
+		}
+		if (STAGES > 2)
+		{
+			y[3] += tune * (z[2] - z[3]);
+			z[3] = FastTanh(y[3] * 0.8192f);
+		}
+		if (STAGES > 3)
+		{
+			y[4] += tune * (z[3] - z[4]);
+			z[4] = FastTanh(y[4] * 0.8192f);
+		}
 	}
-
-#elif FILTER == FILTER_TPT_MOOG
-
-	// nonlinear feedback with gain compensation
-	float const S = (((z[0] * G + z[1]) * G + z[2]) * G + z[3]) * inv1g;
+	else if (MODEL == FILTER_TPT_MOOG)
+	{
+		// nonlinear feedback with gain compensation
+		float const S = (((z[0] * G + z[1]) * G + z[2]) * G + z[3]) * inv1g;
 #if SATURATE == SATURATE_INPUT
-	y[0] = Saturate(alpha0 * (input_adjusted - feedback * S));
+		y[0] = Saturate(alpha0 * (input_adjusted - feedback * S));
 #else
-	y[0] = alpha0 * (input_adjusted - feedback * Saturate(S));
+		y[0] = alpha0 * (input_adjusted - feedback * Saturate(S));
 #endif
 
-	// four-pole low-pass filter
-	register float v;
-	v = (y[0] - z[0]) * G;
-	y[1] = v + z[0];
-	z[0] = y[1] + v;
-	v = (y[1] - z[1]) * G;
-	y[2] = v + z[1];
-	z[1] = y[2] + v;
-	v = (y[2] - z[2]) * G;
-	y[3] = v + z[2];
-	z[2] = y[3] + v;
-	v = (y[3] - z[3]) * G;
-	y[4] = v + z[3];
-	z[3] = y[4] + v;
+		// four-pole low-pass filter
+		register float v;
+		v = (y[0] - z[0]) * G;
+		y[1] = v + z[0];
+		z[0] = y[1] + v;
+		if (STAGES > 1)
+		{
+			v = (y[1] - z[1]) * G;
+			y[2] = v + z[1];
+			z[1] = y[2] + v;
+		}
+		if (STAGES > 2)
+		{
+			v = (y[2] - z[2]) * G;
+			y[3] = v + z[2];
+			z[2] = y[3] + v;
+		}
+		if (STAGES > 3)
+		{
+			v = (y[3] - z[3]) * G;
+			y[4] = v + z[3];
+			z[3] = y[4] + v;
+		}
+	}
+}
 
-#endif
+// bring the stages a reduced render skipped up to the last computed stage
+// (as if they had settled on a steady input, so they feed back smoothly
+// when resonance returns)
+template <FilterModel MODEL, int STAGES> void FilterState::Settle()
+{
+	for (int k = STAGES + 1; k < 5; ++k)
+	{
+		y[k] = y[STAGES];
+		if (MODEL == FILTER_NONLINEAR_MOOG)
+			z[k] = z[STAGES];
+		else if (MODEL == FILTER_TPT_MOOG)
+			z[k - 1] = y[STAGES];
+	}
+	previous = y[4];
+}
+
+// update the filter
+// (repeats the input for each oversampled step)
+template <FilterModel MODEL> __forceinline float FilterState::Update(FilterConfig const &config, float const input)
+{
+	int const oversample = config.GetOversample();
+	for (int i = 0; i < oversample; ++i)
+		Step<MODEL, 4>(config, input);
 
 	// generate output by mixing stage values
-	return
-		y[0] * config.mix[0] +
-		y[1] * config.mix[1] +
-		y[2] * config.mix[2] +
-		y[3] * config.mix[3] +
-		y[4] * config.mix[4];
+	return Mix<4>(config);
+}
+
+// filter a block of samples
+template <FilterModel MODEL, int OVERSAMPLE, int STAGES> void FilterState::Render(FilterConfig const &config, float buffer[], size_t const count)
+{
+	// work on a local copy of the state
+	FilterState local(*this);
+
+	for (size_t base = 0; base < count; base += OVERSAMPLE_BLOCK)
+	{
+		size_t const block = Min<size_t>(count - base, OVERSAMPLE_BLOCK);
+
+		// samples at the oversampled rate
+		float upsampled[OVERSAMPLE_BLOCK * OVERSAMPLE_MAX];
+		float *samples = buffer + base;
+		if (OVERSAMPLE > 1)
+		{
+			local.oversampler.Upsample(OVERSAMPLE, samples, upsampled, block);
+			samples = upsampled;
+		}
+
+		for (size_t i = 0; i < block; ++i)
+		{
+			// step the values toward the next control update
+			local.feedback += local.feedback_step;
+			if (MODEL == FILTER_IMPROVED_MOOG)
+			{
+				local.a1 += local.a1_step;
+				local.b0 += local.b0_step;
+				local.b1 += local.b1_step;
+			}
+			else if (MODEL == FILTER_LINEAR_MOOG || MODEL == FILTER_NONLINEAR_MOOG)
+			{
+				local.tune += local.tune_step;
+			}
+			else if (MODEL == FILTER_TPT_MOOG)
+			{
+				local.G += local.G_step;
+				local.inv1g += local.inv1g_step;
+				local.alpha0 += local.alpha0_step;
+			}
+
+			for (int k = 0; k < OVERSAMPLE; ++k)
+			{
+				float &sample = samples[i * OVERSAMPLE + k];
+				local.Step<MODEL, STAGES>(config, sample);
+				sample = local.Mix<STAGES>(config);
+			}
+		}
+
+		if (OVERSAMPLE > 1)
+			local.oversampler.Downsample(OVERSAMPLE, upsampled, buffer + base, block);
+	}
+
+	if (STAGES < 4)
+		local.Settle<MODEL, STAGES>();
+
+	*this = local;
+}
+
+// filter a block of samples computing only the stages needed
+template <FilterModel MODEL, int OVERSAMPLE> void FilterState::Render(FilterConfig const &config, float buffer[], size_t const count)
+{
+	switch (GetStages(config))
+	{
+	case 1:		Render<MODEL, OVERSAMPLE, 1>(config, buffer, count); break;
+	case 2:		Render<MODEL, OVERSAMPLE, 2>(config, buffer, count); break;
+	case 3:		Render<MODEL, OVERSAMPLE, 3>(config, buffer, count); break;
+	default:	Render<MODEL, OVERSAMPLE, 4>(config, buffer, count); break;
+	}
+}
+
+// filter a block of samples at the configured oversampling factor
+template <FilterModel MODEL> void FilterState::Render(FilterConfig const &config, float buffer[], size_t const count)
+{
+	switch (config.GetOversample())
+	{
+	case 4:		Render<MODEL, 4>(config, buffer, count); break;
+	case 2:		Render<MODEL, 2>(config, buffer, count); break;
+	default:	Render<MODEL, 1>(config, buffer, count); break;
+	}
+}
+
+// compute filter values for the configured filter model
+void FilterState::Setup(FilterConfig const &config, float const cutoff, float const resonance, float const step)
+{
+	Ramp(config, cutoff, resonance, step, 0);
+}
+
+// ramp filter values for the configured filter model
+// (the coefficients run at the oversampled rate)
+void FilterState::Ramp(FilterConfig const &config, float const cutoff, float const resonance, float const base_step, size_t const count)
+{
+	float const step = base_step / config.GetOversample();
+	switch (config.model)
+	{
+	case FILTER_IMPROVED_MOOG:	Ramp<FILTER_IMPROVED_MOOG>(cutoff, resonance, step, count); break;
+	case FILTER_LINEAR_MOOG:	Ramp<FILTER_LINEAR_MOOG>(cutoff, resonance, step, count); break;
+	case FILTER_NONLINEAR_MOOG:	Ramp<FILTER_NONLINEAR_MOOG>(cutoff, resonance, step, count); break;
+	case FILTER_TPT_MOOG:		Ramp<FILTER_TPT_MOOG>(cutoff, resonance, step, count); break;
+	default: __assume(0);
+	}
+}
+
+// update the filter with the configured filter model
+float FilterState::Update(FilterConfig const &config, float const input)
+{
+	switch (config.model)
+	{
+	case FILTER_IMPROVED_MOOG:	return Update<FILTER_IMPROVED_MOOG>(config, input);
+	case FILTER_LINEAR_MOOG:	return Update<FILTER_LINEAR_MOOG>(config, input);
+	case FILTER_NONLINEAR_MOOG:	return Update<FILTER_NONLINEAR_MOOG>(config, input);
+	default:					return Update<FILTER_TPT_MOOG>(config, input);
+	}
+}
+
+// filter a block of samples with the configured filter model
+// (dispatches once per block)
+void FilterState::Render(FilterConfig const &config, float buffer[], size_t const count)
+{
+	switch (config.model)
+	{
+	case FILTER_IMPROVED_MOOG:	Render<FILTER_IMPROVED_MOOG>(config, buffer, count); break;
+	case FILTER_LINEAR_MOOG:	Render<FILTER_LINEAR_MOOG>(config, buffer, count); break;
+	case FILTER_NONLINEAR_MOOG:	Render<FILTER_NONLINEAR_MOOG>(config, buffer, count); break;
+	case FILTER_TPT_MOOG:		Render<FILTER_TPT_MOOG>(config, buffer, count); break;
+	default: __assume(0);
+	}
 }
@@ -7,19 +7,30 @@ Filter
 */
 
 #include "Envelope.h"
+#include "Math.h"
+#include "Oversampler.h"
 
-// filter type
-#define FILTER_IMPROVED_MOOG 0
-#define FILTER_LINEAR_MOOG 1
-#define FILTER_NONLINEAR_MOOG 2
-#define FILTER_TPT_MOOG 3
-#define FILTER 3
+// filter model
+// (each model is a separate instantiation of the block filter, selected per patch)
+enum FilterModel
+{
+	FILTER_IMPROVED_MOOG,	// 2x oversampled by default
+	FILTER_LINEAR_MOOG,		// 2x oversampled by default
+	FILTER_NONLINEAR_MOOG,	// 2x oversampled by default
+	FILTER_TPT_MOOG,		// 1x by default
+
+	FILTER_MODEL_COUNT
+};
+
+// default oversampling factor for each filter model
+extern int const filter_oversample[FILTER_MODEL_COUNT];
 
 // resonant lowpass filter
 class FilterConfig
 {
 public:
 	bool enable;
+	FilterModel model;
 	enum Mode
 	{
 		PEAK,
@@ -53,6 +64,9 @@ public:
 	Mode mode;
 	float mix[5];
 
+	// highest filter stage the mode mixes
+	int stages;
+
 	// drive parameter
 	float drive;
 
@@ -71,8 +85,13 @@ public:
 	// key follow
 	float key_follow;
 
-	FilterConfig(bool const enable, Mode const mode, float const drive, float const compensation, float const resonance, float const cutoff_base, float const cutoff_lfo, float const cutoff_env, float const cutoff_env_vel, float const key_follow)
+	// oversampling factor (1, 2, or 4)
+	// (0 uses the filter model's default)
+	int oversample;
+
+	FilterConfig(bool const enable, FilterModel const model, Mode const mode, float const drive, float const compensation, float const resonance, float const cutoff_base, float const cutoff_lfo, float const cutoff_env, float const cutoff_env_vel, float const key_follow)
 		: enable(enable)
+		, model(model)
 		, drive(drive)
 		, compensation(compensation)
 		, resonance(resonance)
@@ -81,6 +100,7 @@ public:
 		, cutoff_env(cutoff_env)
 		, cutoff_env_vel(cutoff_env_vel)
 		, key_follow(key_follow)
+		, oversample(0)
 	{
 		SetMode(mode);
 	}
@@ -89,9 +109,15 @@ public:
 	void SetMode(Mode newmode);
 
 	// get the modulated cutoff value
-	float GetCutoff(float const lfo, float const env, float const vel)
+	float GetCutoff(float const lfo, float const env, float const vel) const
 	{
-		return powf(2, cutoff_base + lfo * cutoff_lfo + env * (cutoff_env + vel * cutoff_env_vel));
+		return FastExp2(cutoff_base + lfo * cutoff_lfo + env * (cutoff_env + vel * cutoff_env_vel));
+	}
+
+	// get the oversampling factor in effect
+	int GetOversample() const
+	{
+		return oversample ? oversample : filter_oversample[model];
 	}
 };
 
@@ -102,9 +128,7 @@ public:
 	// feedback coefficient
 	float feedback;
 
-#if FILTER == FILTER_NONLINEAR_MOOG
-
-#define FILTER_OVERSAMPLE 2
+	// FILTER_LINEAR_MOOG and FILTER_NONLINEAR_MOOG:
 
 	// output delayed by half a sample for phase compensation
 	float previous;
@@ -113,23 +137,7 @@ public:
 	// tuning coefficient
 	float tune;
 
-	// nonlinear output values from each stage
-	float z[5];
-
-#elif FILTER == FILTER_LINEAR_MOOG
-
-#define FILTER_OVERSAMPLE 2
-
-	// output delayed by half a sample for phase compensation
-	float previous;
-	float delayed;
-
-	// tuning coefficient
-	float tune;
-
-#elif FILTER == FILTER_IMPROVED_MOOG
-
-#define FILTER_OVERSAMPLE 2
+	// FILTER_IMPROVED_MOOG:
 
 	// filter stage IIR coefficients
 	// H(z) = (b0 * z + b1) / (z + a1)
@@ -142,31 +150,88 @@ public:
 	// y[n] = b0 * x[n] + b1 * x[n-1] - a1 * y[n-1]
 	float b0, b1, a1;
 
-#elif FILTER == FILTER_TPT_MOOG
-
-#define FILTER_OVERSAMPLE 1
+	// FILTER_TPT_MOOG:
 
 	// parameters derived from cutoff and resonance
 	float inv1g, G, alpha0;
 
-	// delay element values
-	float z[4];
-
-#endif
+	// FILTER_NONLINEAR_MOOG: nonlinear output values from each stage
+	// FILTER_TPT_MOOG: delay element values (first four)
+	float z[5];
 
 	// linear output values from each stage
 	// (y[0] is input to the first stage)
 	float y[5];
 
+	// per-sample coefficient changes while ramping to the next control update
+	float feedback_step;
+	float tune_step;
+	float a1_step, b0_step, b1_step;
+	float G_step, inv1g_step, alpha0_step;
+
+	// coefficients have been set since the last reset
+	// (the first ramp after a reset jumps straight to its target)
+	bool primed;
+
+	// resampling around the filter when oversampling
+	Oversampler oversampler;
+
 	FilterState()
 	{
 		Reset();
 	}
 	void Reset(void);
-	void Setup(float const cutoff, float const resonance, float const step);
+
+	// set coefficients immediately
+	void Setup(FilterConfig const &config, float const cutoff, float const resonance, float const step);
+
+	// ramp coefficients to new values over the next count samples of Render
+	void Ramp(FilterConfig const &config, float const cutoff, float const resonance, float const step, size_t const count);
+
+	// filter one sample
+	// (holds the input for each oversampled step; for displays only)
 	float Update(FilterConfig const &config, float const input);
+
+	// filter a block of samples in place
+	// (resamples the block when oversampling)
+	void Render(FilterConfig const &config, float buffer[], size_t const count);
+
+	// implementations for each filter model
+	// (step values apply to the oversampled rate; STAGES is the number of stages computed)
+	template <FilterModel MODEL> void Setup(float const cutoff, float const resonance, float const step);
+	template <FilterModel MODEL> void Ramp(float const cutoff, float const resonance, float const step, size_t const count);
+	template <FilterModel MODEL, int STAGES> void Step(FilterConfig const &config, float const input);
+	template <FilterModel MODEL, int STAGES> void Settle();
+	template <FilterModel MODEL> float Update(FilterConfig const &config, float const input);
+	template <FilterModel MODEL, int OVERSAMPLE, int STAGES> void Render(FilterConfig const &config, float buffer[], size_t const count);
+	template <FilterModel MODEL, int OVERSAMPLE> void Render(FilterConfig const &config, float buffer[], size_t const count);
+	template <FilterModel MODEL> void Render(FilterConfig const &config, float buffer[], size_t const count);
+
+	// get the number of stages to compute until the next control update
+	// (the ladder feeds back from its last stage, so resonance needs all four;
+	// without it, stages past the ones the mode mixes cannot affect the output)
+	int GetStages(FilterConfig const &config) const
+	{
+		return (feedback != 0.0f || feedback_step != 0.0f) ? 4 : config.stages;
+	}
+
+	// mix stage values into the filter output
+	// (stages past STAGES have no weight in the mode)
+	template <int STAGES> float Mix(FilterConfig const &config) const
+	{
+		float value = y[0] * config.mix[0];
+		for (int k = 1; k <= STAGES; ++k)
+			value += y[k] * config.mix[k];
+		return value;
+	}
 };
 
+// build the filter tuning table
+extern void InitFilter();
+
+// filter model names
+extern char const * const filter_model_name[FILTER_MODEL_COUNT];
+
 // filter mode names
 extern char const * const filter_name[FilterConfig::COUNT];
 
@@ -177,7 +242,7 @@ extern FilterConfig flt_config;
 extern EnvelopeConfig flt_env_config;
 
 // filter state
-extern FilterState flt_state[];
+extern FilterState *flt_state;
 
 // filter envelope state
-extern EnvelopeState flt_env_state[];
+extern EnvelopeState *flt_env_state;
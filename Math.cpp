@@ -0,0 +1,117 @@
+/*
+MINI VIRTUAL ANALOG SYNTHESIZER
+Copyright 2014 Kenneth D. Miller III
+
+Math Functions
+*/
+#include "StdAfx.h"
+
+#include "Math.h"
+
+// octaves on either side of middle C covered by the measurement
+#define MEASURE_OCTAVES 16
+
+// measurement steps per octave (quarter cent)
+#define MEASURE_STEPS 4800
+
+// error in cents of an approximate 2^x
+static double Exp2Cents(double const x, float const approx)
+{
+	return 1200.0 * fabs(log(double(approx)) / log(2.0) - x);
+}
+
+// error in cents of an approximate log2(2^x)
+static double Log2Cents(float const value, float const approx)
+{
+	return 1200.0 * fabs(double(approx) - log(double(value)) / log(2.0));
+}
+
+// measure the largest FastExp2 and FastLog2 errors in cents
+void MeasureFastMath(float &exp2_cents, float &log2_cents)
+{
+	double exp2_worst = 0.0;
+	double log2_worst = 0.0;
+	for (int i = -MEASURE_OCTAVES * MEASURE_STEPS; i <= MEASURE_OCTAVES * MEASURE_STEPS; ++i)
+	{
+		float const x = float(i) / MEASURE_STEPS;
+		float const value = float(pow(2.0, double(x)));
+
+		exp2_worst = Max(exp2_worst, Exp2Cents(x, FastExp2(x)));
+		log2_worst = Max(log2_worst, Log2Cents(value, FastLog2(value)));
+
+#if _M_IX86_FP > 0
+		float lane[4];
+		_mm_storeu_ps(lane, FastExp2(_mm_set1_ps(x)));
+		exp2_worst = Max(exp2_worst, Exp2Cents(x, lane[3]));
+		_mm_storeu_ps(lane, FastLog2(_mm_set1_ps(value)));
+		log2_worst = Max(log2_worst, Log2Cents(value, lane[3]));
+#endif
+
+#if defined(__AVX2__)
+		float wide[8];
+		_mm256_storeu_ps(wide, FastExp2(_mm256_set1_ps(x)));
+		exp2_worst = Max(exp2_worst, Exp2Cents(x, wide[7]));
+		_mm256_storeu_ps(wide, FastLog2(_mm256_set1_ps(value)));
+		log2_worst = Max(log2_worst, Log2Cents(value, wide[7]));
+#endif
+	}
+	exp2_cents = float(exp2_worst);
+	log2_cents = float(log2_worst);
+}
+
+// pi in double precision
+static double const PI = 3.14159265358979323846;
+
+// in-place radix-2 complex fourier transform
+void FourierTransform(double re[], double im[], int const n, bool const inverse)
+{
+	// bit-reversal permutation
+	for (int i = 1, j = 0; i < n; ++i)
+	{
+		int bit = n >> 1;
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+		if (i < j)
+		{
+			double t = re[i]; re[i] = re[j]; re[j] = t;
+			t = im[i]; im[i] = im[j]; im[j] = t;
+		}
+	}
+
+	// butterflies
+	for (int size = 2; size <= n; size <<= 1)
+	{
+		double const angle = (inverse ? 2.0 : -2.0) * PI / size;
+		double const wr = cos(angle);
+		double const wi = sin(angle);
+		for (int start = 0; start < n; start += size)
+		{
+			double cr = 1.0, ci = 0.0;
+			for (int k = 0; k < size / 2; ++k)
+			{
+				int const a = start + k;
+				int const b = a + size / 2;
+				double const tr = re[b] * cr - im[b] * ci;
+				double const ti = re[b] * ci + im[b] * cr;
+				re[b] = re[a] - tr;
+				im[b] = im[a] - ti;
+				re[a] += tr;
+				im[a] += ti;
+				double const nr = cr * wr - ci * wi;
+				ci = cr * wi + ci * wr;
+				cr = nr;
+			}
+		}
+	}
+
+	// scale the inverse
+	if (inverse)
+	{
+		for (int i = 0; i < n; ++i)
+		{
+			re[i] /= n;
+			im[i] /= n;
+		}
+	}
+}
@@ -66,7 +66,10 @@ static inline float FastTanh(float x)
 // The input value must be in the interval [-2**30, 2**30-1]
 
 #if _M_IX86_FP > 0
-#include <xmmintrin.h>
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
 #endif
 
 // fast integer round
@@ -155,3 +158,152 @@ static inline int TruncateInt(float const x)
 	return x >= 0 ? i : -i;
 #endif
 }
+
+// index of the lowest set bit
+// (x must not be zero)
+static inline int CountTrailingZeros(unsigned int const x)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, x);
+	return int(index);
+#else
+	return __builtin_ctz(x);
+#endif
+}
+
+// Fast base-2 exponential and logarithm for pitch and cutoff math
+// Both split the argument into an exponent and a fraction and evaluate a
+// minimax polynomial on the fraction.  Over the pitch and cutoff range
+// (2^-16 to 2^16) the error is within 0.01 cent for FastExp2 and within
+// 0.02 cent for FastLog2, well under the 1-2 cent limit of pitch perception.
+// MeasureFastMath checks both against the C library.
+
+// largest FastExp2 and FastLog2 errors in cents
+#define FAST_EXP2_CENTS 0.01f
+#define FAST_LOG2_CENTS 0.02f
+
+// fast approximation of 2^x
+// (x is clamped to [-126, 126])
+static inline float FastExp2(float x)
+{
+	x = Clamp(x, -126.0f, 126.0f);
+	int const i = FloorInt(x);
+	float const f = x - float(i);
+	union { float f; int i; } u;
+	u.f = 1.00000259f + f * (0.693003834f + f * (0.241442757f + f * (0.0520114606f + f * 0.0135341679f)));
+	u.i += i << 23;
+	return u.f;
+}
+
+// fast approximation of log2(x)
+// (x must be positive and normal)
+static inline float FastLog2(float const x)
+{
+	union { float f; int i; } u;
+	u.f = x;
+	int const e = ((u.i >> 23) & 255) - 127;
+	u.i = (u.i & 0x007FFFFF) | 0x3F800000;
+	float const m = u.f - 1.0f;
+	return float(e) + (1.25387446e-05f + m * (1.44168456f + m * (-0.707992651f + m * (0.41363012f + m * (-0.192195636f + m * 0.0448736103f)))));
+}
+
+#if _M_IX86_FP > 0
+// four-lane FastExp2
+static inline __m128 FastExp2(__m128 x)
+{
+	x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-126.0f)), _mm_set1_ps(126.0f));
+	__m128 fi = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+	fi = _mm_sub_ps(fi, _mm_and_ps(_mm_cmplt_ps(x, fi), _mm_set1_ps(1.0f)));
+	__m128 const f = _mm_sub_ps(x, fi);
+	__m128 p = _mm_set1_ps(0.0135341679f);
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(0.0520114606f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(0.241442757f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(0.693003834f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.00000259f));
+	return _mm_castsi128_ps(_mm_add_epi32(_mm_castps_si128(p), _mm_slli_epi32(_mm_cvttps_epi32(fi), 23)));
+}
+
+// four-lane FastLog2
+static inline __m128 FastLog2(__m128 const x)
+{
+	__m128i const bits = _mm_castps_si128(x);
+	__m128 const e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_and_si128(_mm_srli_epi32(bits, 23), _mm_set1_epi32(255)), _mm_set1_epi32(127)));
+	__m128 const m = _mm_sub_ps(_mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F800000))), _mm_set1_ps(1.0f));
+	__m128 p = _mm_set1_ps(0.0448736103f);
+	p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(-0.192195636f));
+	p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(0.41363012f));
+	p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(-0.707992651f));
+	p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(1.44168456f));
+	p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(1.25387446e-05f));
+	return _mm_add_ps(e, p);
+}
+#endif
+
+#if defined(__AVX2__)
+// eight-lane FastExp2
+static inline __m256 FastExp2(__m256 x)
+{
+	x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-126.0f)), _mm256_set1_ps(126.0f));
+	__m256 const fi = _mm256_floor_ps(x);
+	__m256 const f = _mm256_sub_ps(x, fi);
+	__m256 p = _mm256_set1_ps(0.0135341679f);
+	p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(0.0520114606f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(0.241442757f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(0.693003834f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(1.00000259f));
+	return _mm256_castsi256_ps(_mm256_add_epi32(_mm256_castps_si256(p), _mm256_slli_epi32(_mm256_cvttps_epi32(fi), 23)));
+}
+
+// eight-lane FastLog2
+static inline __m256 FastLog2(__m256 const x)
+{
+	__m256i const bits = _mm256_castps_si256(x);
+	__m256 const e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_and_si256(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(255)), _mm256_set1_epi32(127)));
+	__m256 const m = _mm256_sub_ps(_mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)), _mm256_set1_epi32(0x3F800000))), _mm256_set1_ps(1.0f));
+	__m256 p = _mm256_set1_ps(0.0448736103f);
+	p = _mm256_add_ps(_mm256_mul_ps(p, m), _mm256_set1_ps(-0.192195636f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, m), _mm256_set1_ps(0.41363012f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, m), _mm256_set1_ps(-0.707992651f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, m), _mm256_set1_ps(1.44168456f));
+	p = _mm256_add_ps(_mm256_mul_ps(p, m), _mm256_set1_ps(1.25387446e-05f));
+	return _mm256_add_ps(e, p);
+}
+#endif
+
+// measure the largest FastExp2 and FastLog2 errors in cents against the C
+// library over the pitch and cutoff range, including the lane versions
+extern void MeasureFastMath(float &exp2_cents, float &log2_cents);
+
+// in-place radix-2 complex fourier transform for building tables
+// (n must be a power of two; the inverse is scaled by 1/n)
+extern void FourierTransform(double re[], double im[], int const n, bool const inverse);
+
+// flush denormals
+// (returns the previous mode)
+static inline unsigned int FlushDenormals()
+{
+#if defined(_MSC_VER)
+	unsigned int prev;
+	_controlfp_s(&prev, _DN_FLUSH, _MCW_DN);
+	return prev;
+#elif _M_IX86_FP > 0
+	unsigned int const prev = _mm_getcsr();
+	_mm_setcsr(prev | 0x8040);	// flush to zero, denormals are zero
+	return prev;
+#else
+	return 0;
+#endif
+}
+
+// restore denormals
+static inline void RestoreDenormals(unsigned int prev)
+{
+#if defined(_MSC_VER)
+	_controlfp_s(&prev, prev, _MCW_DN);
+#elif _M_IX86_FP > 0
+	_mm_setcsr(prev);
+#else
+	(void)prev;
+#endif
+}
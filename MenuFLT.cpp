@@ -24,6 +24,22 @@ namespace Menu
 			flt_config.enable = sign > 0;
 			flt_env_config.enable = sign > 0;
 			break;
+		case MODEL:
+			if (modifiers & SHIFT_PRESSED)
+			{
+				// cycle oversampling: model default, 1x, 2x, 4x
+				static int const oversample_cycle[] = { 0, 1, 2, 4 };
+				int step = 0;
+				while (oversample_cycle[step] != flt_config.oversample)
+					++step;
+				step = (step + ARRAY_SIZE(oversample_cycle) + sign) % ARRAY_SIZE(oversample_cycle);
+				flt_config.oversample = oversample_cycle[step];
+			}
+			else
+			{
+				flt_config.model = FilterModel((flt_config.model + FILTER_MODEL_COUNT + sign) % FILTER_MODEL_COUNT);
+			}
+			break;
 		case MODE:
 			flt_config.SetMode(FilterConfig::Mode((flt_config.mode + FilterConfig::COUNT + sign) % FilterConfig::COUNT));
 			break;
@@ -78,6 +94,10 @@ namespace Menu
 		case TITLE:
 			PrintTitle(hOut, flt_config.enable, flags, NULL, "OFF");
 			break;
+		case MODEL:
+			PrintItemString(hOut, pos, flags, "%-15s", filter_model_name[flt_config.model]);
+			PrintItemFloat(hOut, { pos.X + 15, pos.Y }, flags, "%2.0fx", float(flt_config.GetOversample()));
+			break;
 		case MODE:
 			PrintItemString(hOut, pos, flags, "%-18s", filter_name[flt_config.mode]);
 			break;
@@ -16,6 +16,7 @@ namespace Menu
 		enum Item
 		{
 			TITLE,
+			MODEL,
 			MODE,
 			DRIVE,
 			COMPENSATION,
@@ -42,7 +42,7 @@ namespace Menu
 			break;
 		case WAVETYPE:
 			config.SetWaveType(Wave((config.wavetype + WAVE_COUNT + sign) % WAVE_COUNT));
-			for (int v = 0; v < VOICES; ++v)
+			for (int v = 0; v < voice_count; ++v)
 				osc_state[v][osc].Reset();
 			break;
 		case WAVEPARAM_BASE:
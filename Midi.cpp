@@ -8,9 +8,7 @@ MIDI Support
 
 #include "Debug.h"
 #include "Midi.h"
-#include "Voice.h"
-#include "Control.h"
-#include "Amplifier.h"
+#include "EventQueue.h"
 
 // midi messages
 // http://www.midi.org/techspecs/midimessages.php
@@ -55,6 +53,17 @@ namespace Midi
 		// default to listening on all channels
 		int listen_channels = ~0U;
 
+		// system time when input started
+		// (message time stamps are relative to this)
+		DWORD start_time;
+
+		// queue a message for the render thread
+		static void Queue(DWORD_PTR dwParam1, DWORD_PTR dwParam2)
+		{
+			if (!EventQueue::Push(EventQueue::SOURCE_MIDI, start_time + DWORD(dwParam2), (unsigned char)(dwParam1), (unsigned char)(dwParam1 >> 8), (unsigned char)(dwParam1 >> 16)))
+				DebugPrint("MIDI event queue full\n");
+		}
+
 		void HandleData(DWORD_PTR dwInstance, DWORD_PTR dwParam1, DWORD_PTR dwParam2)
 		{
 			unsigned char channel = ((dwParam1)& 0xF) + 1;
@@ -78,14 +87,11 @@ namespace Midi
 			{
 			case MIDI_NOTE_OFF:
 				DebugPrint("Note Off:       note=%d velocity=%d\n", data1, data2);
-				NoteOff(data1, data2);
+				Queue(dwParam1, dwParam2);
 				break;
 			case MIDI_NOTE_ON:
 				DebugPrint("Note On:        note=%d velocity=%d\n", data1, data2);
-				if (data2)
-					NoteOn(data1, data2);
-				else
-					NoteOff(data1);
+				Queue(dwParam1, dwParam2);
 				break;
 			case MIDI_KEY_PRESSURE:
 				DebugPrint("Key Pressure:   note=%d pressure=%d\n", data1, data2);
@@ -98,24 +104,18 @@ namespace Midi
 					break;
 				case MIDI_ALL_SOUND_OFF:
 					DebugPrint("All Sound Off\n");
-					for (int v = 0; v < VOICES; ++v)
-					{
-						NoteOff(voice_note[v], 0);
-						amp_env_state[v].amplitude = 0;
-						amp_env_state[v].state = EnvelopeState::OFF;
-					}
+					Queue(dwParam1, dwParam2);
 					break;
 				case MIDI_RESET_ALL_CONTROLLERS:
 					DebugPrint("Reset All Controllers\n");
-					Control::ResetAll();
+					Queue(dwParam1, dwParam2);
 					break;
 				case MIDI_LOCAL_CONTROL:
 					DebugPrint("Local Control %s\n", data2 ? "On" : "Off");
 					break;
 				case MIDI_ALL_NOTES_OFF:
 					DebugPrint("All Notes Off\n");
-					for (int v = 0; v < VOICES; ++v)
-						NoteOff(voice_note[v], 0);
+					Queue(dwParam1, dwParam2);
 					break;
 				case MIDI_OMNI_MODE_OFF:
 					DebugPrint("Omni Mode Off\n");
@@ -139,7 +139,7 @@ namespace Midi
 				break;
 			case MIDI_PITCH_WHEEL_CHANGE:
 				DebugPrint("Pitch Wheel Change: value=%d\n", (data2 << 7) + data1 - 0x2000);
-				Control::SetPitchWheel((data2 << 7) + data1 - 0x2000);
+				Queue(dwParam1, dwParam2);
 				break;
 			case MIDI_SYSTEM:
 				DebugPrint("System %02x %02x %02x\n", data1, data2);
@@ -253,6 +253,7 @@ namespace Midi
 			if (handle)
 			{
 				// start midi input
+				start_time = timeGetTime();
 				midiInStart(handle);
 				stopping = false;
 			}
@@ -0,0 +1,266 @@
+/*
+MINI VIRTUAL ANALOG SYNTHESIZER
+Copyright 2014 Kenneth D. Miller III
+
+Standard MIDI File Support
+*/
+#include "StdAfx.h"
+
+#include "MidiFile.h"
+
+// standard midi file format
+// http://www.midi.org/techspecs/smf.php
+
+namespace Midi
+{
+	namespace File
+	{
+		// default tempo in microseconds per quarter note (120 bpm)
+		static unsigned int const DEFAULT_TEMPO = 500000;
+
+		// event in track time
+		struct TrackEvent
+		{
+			unsigned int tick;		// absolute time in ticks
+			unsigned int order;		// file order for events on the same tick
+			unsigned int tempo;		// new tempo for set-tempo events
+			unsigned char status;	// status byte (0xFF for set-tempo)
+			unsigned char data1;
+			unsigned char data2;
+		};
+
+		// growable track event array
+		struct TrackEventList
+		{
+			TrackEvent *data;
+			int count;
+			int capacity;
+		};
+
+		// append an event to the list
+		static bool Append(TrackEventList &list, TrackEvent const &event)
+		{
+			if (list.count >= list.capacity)
+			{
+				int const capacity = list.capacity ? list.capacity * 2 : 1024;
+				TrackEvent *data = static_cast<TrackEvent *>(realloc(list.data, capacity * sizeof(TrackEvent)));
+				if (!data)
+					return false;
+				list.data = data;
+				list.capacity = capacity;
+			}
+			list.data[list.count++] = event;
+			return true;
+		}
+
+		// read a big-endian value
+		static unsigned int ReadBigEndian(unsigned char const *data, int bytes)
+		{
+			unsigned int value = 0;
+			for (int i = 0; i < bytes; ++i)
+				value = (value << 8) | data[i];
+			return value;
+		}
+
+		// read a variable-length quantity
+		static bool ReadVariable(unsigned char const *&data, unsigned char const *end, unsigned int &value)
+		{
+			value = 0;
+			for (int i = 0; i < 4; ++i)
+			{
+				if (data >= end)
+					return false;
+				unsigned char const c = *data++;
+				value = (value << 7) | (c & 0x7F);
+				if (!(c & 0x80))
+					return true;
+			}
+			return false;
+		}
+
+		// parse a track chunk
+		static bool ParseTrack(unsigned char const *data, unsigned char const *end, TrackEventList &list)
+		{
+			unsigned int tick = 0;
+			unsigned char running = 0;
+			while (data < end)
+			{
+				// delta time
+				unsigned int delta;
+				if (!ReadVariable(data, end, delta))
+					return false;
+				tick += delta;
+
+				if (data >= end)
+					return false;
+				unsigned char status = *data;
+				if (status & 0x80)
+					++data;
+				else if (running)
+					status = running;
+				else
+					return false;
+
+				if (status == 0xFF)
+				{
+					// meta event
+					if (data >= end)
+						return false;
+					unsigned char const type = *data++;
+					unsigned int length;
+					if (!ReadVariable(data, end, length) || length > (unsigned int)(end - data))
+						return false;
+					if (type == 0x51 && length == 3)
+					{
+						// set tempo
+						TrackEvent const event = { tick, (unsigned int)(list.count), ReadBigEndian(data, 3), 0xFF, 0, 0 };
+						if (!Append(list, event))
+							return false;
+					}
+					else if (type == 0x2F)
+					{
+						// end of track
+						return true;
+					}
+					data += length;
+					running = 0;
+				}
+				else if (status == 0xF0 || status == 0xF7)
+				{
+					// system exclusive event (ignored)
+					unsigned int length;
+					if (!ReadVariable(data, end, length) || length > (unsigned int)(end - data))
+						return false;
+					data += length;
+					running = 0;
+				}
+				else if (status >= 0x80 && status < 0xF0)
+				{
+					// channel message
+					int const length = (status & 0xE0) == 0xC0 ? 1 : 2;
+					if (end - data < length)
+						return false;
+					TrackEvent const event = { tick, (unsigned int)(list.count), 0, status, data[0], length > 1 ? data[1] : (unsigned char)(0) };
+					if (!Append(list, event))
+						return false;
+					data += length;
+					running = status;
+				}
+				else
+				{
+					// unexpected system common message
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// sort events by tick then file order
+		static int CompareTrackEvents(void const *a, void const *b)
+		{
+			TrackEvent const &ea = *static_cast<TrackEvent const *>(a);
+			TrackEvent const &eb = *static_cast<TrackEvent const *>(b);
+			if (ea.tick != eb.tick)
+				return ea.tick < eb.tick ? -1 : 1;
+			return ea.order < eb.order ? -1 : ea.order > eb.order;
+		}
+
+		// load channel messages from a standard midi file
+		int Load(char const *filename, Event *&events)
+		{
+			events = NULL;
+
+			// read the whole file
+			FILE *file = fopen(filename, "rb");
+			if (!file)
+				return -1;
+			fseek(file, 0, SEEK_END);
+			long const size = ftell(file);
+			fseek(file, 0, SEEK_SET);
+			unsigned char *buffer = static_cast<unsigned char *>(malloc(size > 0 ? size : 1));
+			bool ok = buffer && size >= 14 && fread(buffer, 1, size, file) == size_t(size);
+			fclose(file);
+
+			unsigned char const *data = buffer;
+			unsigned char const *end = buffer + size;
+
+			// header chunk
+			ok = ok && memcmp(data, "MThd", 4) == 0 && ReadBigEndian(data + 4, 4) >= 6;
+			unsigned int const tracks = ok ? ReadBigEndian(data + 10, 2) : 0;
+			unsigned int const division = ok ? ReadBigEndian(data + 12, 2) : 0;
+			if (ok)
+				data += 8 + ReadBigEndian(data + 4, 4);
+			ok = ok && division != 0;
+
+			// track chunks
+			TrackEventList list = { NULL, 0, 0 };
+			for (unsigned int track = 0; ok && track < tracks && end - data >= 8; )
+			{
+				unsigned int const length = ReadBigEndian(data + 4, 4);
+				if (length > (unsigned int)(end - data - 8))
+				{
+					ok = false;
+					break;
+				}
+				if (memcmp(data, "MTrk", 4) == 0)
+				{
+					ok = ParseTrack(data + 8, data + 8 + length, list);
+					++track;
+				}
+				data += 8 + length;
+			}
+			free(buffer);
+
+			if (!ok)
+			{
+				free(list.data);
+				return -1;
+			}
+
+			// merge tracks
+			qsort(list.data, list.count, sizeof(TrackEvent), CompareTrackEvents);
+
+			// convert ticks to seconds
+			events = static_cast<Event *>(malloc((list.count > 0 ? list.count : 1) * sizeof(Event)));
+			if (!events)
+			{
+				free(list.data);
+				return -1;
+			}
+			int count = 0;
+			double time = 0.0;
+			unsigned int tick = 0;
+			double seconds_per_tick;
+			if (division & 0x8000)
+			{
+				// SMPTE frames per second and ticks per frame
+				int const fps = -(signed char)(division >> 8);
+				seconds_per_tick = 1.0 / (fps * (division & 0xFF));
+			}
+			else
+			{
+				// ticks per quarter note
+				seconds_per_tick = DEFAULT_TEMPO * 1.0e-6 / division;
+			}
+			for (int i = 0; i < list.count; ++i)
+			{
+				TrackEvent const &event = list.data[i];
+				time += (event.tick - tick) * seconds_per_tick;
+				tick = event.tick;
+				if (event.status == 0xFF)
+				{
+					if (!(division & 0x8000))
+						seconds_per_tick = event.tempo * 1.0e-6 / division;
+				}
+				else
+				{
+					Event const out = { time, event.status, event.data1, event.data2 };
+					events[count++] = out;
+				}
+			}
+			free(list.data);
+
+			return count;
+		}
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+/*
+MINI VIRTUAL ANALOG SYNTHESIZER
+Copyright 2014 Kenneth D. Miller III
+
+Standard MIDI File Support
+*/
+
+namespace Midi
+{
+	namespace File
+	{
+		// timed channel message
+		struct Event
+		{
+			double time;			// time in seconds from the start
+			unsigned char status;	// status byte (including channel)
+			unsigned char data1;	// first data byte
+			unsigned char data2;	// second data byte (if any)
+		};
+
+		// load channel messages from a standard midi file
+		// (merges all tracks and applies tempo changes)
+		// returns the number of events or -1 on failure
+		// the caller releases the event array with free()
+		extern int Load(char const *filename, Event *&events);
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+/*
+MINI VIRTUAL ANALOG SYNTHESIZER
+Copyright 2014 Kenneth D. Miller III
+
+Minimum-Phase Bandlimited Step
+(based on Brandt, "Hard Sync Without Aliasing")
+*/
+
+// MinBLEP
+// Table-driven correction for C0 (value) and C1 (slope) discontinuities
+
+// A blackman-windowed sinc is converted to minimum phase through the real
+// cepstrum, then integrated once for the bandlimited step and twice for the
+// bandlimited ramp.  The tables hold the difference between those and the
+// ideal step and ramp, so an oscillator renders its naive wave and adds the
+// residual for each discontinuity into a short ring buffer that plays out
+// over the following samples.  Unlike PolyBLEP the kernel can be as wide as
+// needed: its cost is one table add per discontinuity instead of a check on
+// every sample.
+
+// samples covered by each correction
+// (a power of two, since it is also the residual ring buffer length)
+#define MINBLEP_TAPS 16
+
+// table entries per sample
+#define MINBLEP_OVERSAMPLE 64
+
+// The tables are precomputed in WaveData.cpp by the table generator.
+
+// bandlimited step residual: step(t) - 1 for t in [0, MINBLEP_TAPS]
+extern float const minblep_step[MINBLEP_TAPS * MINBLEP_OVERSAMPLE + 1];
+
+// bandlimited ramp residual: ramp(t) - t + delay for t in [0, MINBLEP_TAPS]
+extern float const minblep_ramp[MINBLEP_TAPS * MINBLEP_OVERSAMPLE + 1];
+
+// group delay of the minimum-phase kernel in samples
+// (naive wave segments with slope s must be offset by -s * delay to line up
+// with the corrected discontinuities)
+extern float const minblep_delay;
@@ -16,6 +16,9 @@ void OscillatorState::Reset()
 	phase = 0.0f;
 	index = 0;
 	memset(f, 0, sizeof(f));
+	memset(residual, 0, sizeof(residual));
+	residual_pos = 0;
+	random.Seed(0);
 }
 
 // start oscillator
@@ -25,6 +28,13 @@ void OscillatorState::Start()
 	phase = 0.0f;
 }
 
+// start oscillator with a new random number stream
+void OscillatorState::Start(unsigned int const seed)
+{
+	Start();
+	random.Seed(seed);
+}
+
 // update oscillator
 float OscillatorState::Update(OscillatorConfig const &config, float const step)
 {
@@ -48,30 +58,13 @@ float OscillatorState::Compute(OscillatorConfig const &config, float delta)
 // advance the oscillator phase
 void OscillatorState::Advance(OscillatorConfig const &config, float delta)
 {
-	phase += delta;
 #if 1
-	int const advance = FloorInt(phase);
-	if (advance)
-	{
-		// wrap phase around
-		phase -= advance;
-
-		// advance the wavetable index
-		index += advance;
-		if (index >= int(config.cycle))
-			index -= int(config.cycle);
-		else if (index < 0)
-			index += int(config.cycle);
-	}
 	if (config.sync_enable)
-	{
-		if (phase >= config.sync_phase - index)
-		{
-			phase -= config.sync_phase - index;
-			index = 0;
-		}
-	}
+		Advance<true>(config, delta);
+	else
+		Advance<false>(config, delta);
 #else
+	phase += delta;
 	if (phase >= config.sync_phase)
 	{
 		// wrap phase around
@@ -7,6 +7,9 @@ Oscillator
 */
 
 #include "Wave.h"
+#include "Math.h"
+#include "MinBLEP.h"
+#include "Random.h"
 
 // base frequency oscillator configuration
 class OscillatorConfig
@@ -19,6 +22,10 @@ public:
 	float frequency;
 	float amplitude;
 
+	// amplitude at the start of the control update
+	// (block renderers ramp from here to amplitude)
+	float amplitude_begin;
+
 	// hard sync
 	bool sync_enable;
 	float sync_phase;
@@ -34,6 +41,7 @@ public:
 		, waveparam(waveparam)
 		, frequency(frequency)
 		, amplitude(amplitude)
+		, amplitude_begin(amplitude)
 		, sync_enable(false)
 		, sync_phase(1.0f)
 	{
@@ -63,6 +71,15 @@ public:
 		int i[8];
 	};
 
+	// minBLEP corrections still to be added to upcoming samples
+	float residual[MINBLEP_TAPS];
+	int residual_pos;
+
+	// random number stream for noise waves
+	// (each oscillator has its own, so renders do not depend on the order
+	// in which voices are processed)
+	Random::Stream random;
+
 	OscillatorState()
 	{
 		Reset();
@@ -74,6 +91,9 @@ public:
 	// start the oscillator
 	void Start();
 
+	// start the oscillator with a new random number stream
+	void Start(unsigned int const seed);
+
 	// update the oscillator by one step
 	float Update(OscillatorConfig const &config, float const step);
 
@@ -82,4 +102,146 @@ public:
 
 	// advance the oscillator phase
 	void Advance(OscillatorConfig const &config, float delta);
+
+	// advance the oscillator phase with hard sync selected at compile time
+	template <bool SYNC> void Advance(OscillatorConfig const &config, float delta);
+
+	// add a minBLEP correction for a value step of height units
+	// (x: time since the step at the next sample, in samples)
+	void AddStep(float const x, float const height);
+
+	// add a minBLEP correction for a slope change of slope units per sample
+	void AddRamp(float const x, float const slope);
+
+	// take the minBLEP correction for the next sample
+	float TakeResidual();
 };
+
+// add a correction from a minBLEP residual table
+static __forceinline void AddResidual(float residual[MINBLEP_TAPS], int const pos, float const table[], float const x, float const scale)
+{
+	float const t = x * MINBLEP_OVERSAMPLE;
+	int const j = Min(FloorInt(t), MINBLEP_OVERSAMPLE - 1);
+	float const f = t - float(j);
+	for (int k = 0; k < MINBLEP_TAPS; ++k)
+	{
+		float const *entry = table + j + k * MINBLEP_OVERSAMPLE;
+		residual[(pos + k) & (MINBLEP_TAPS - 1)] += scale * (entry[0] + (entry[1] - entry[0]) * f);
+	}
+}
+
+// add a minBLEP correction for a value step
+__forceinline void OscillatorState::AddStep(float const x, float const height)
+{
+	AddResidual(residual, residual_pos, minblep_step, x, height);
+}
+
+// add a minBLEP correction for a slope change
+__forceinline void OscillatorState::AddRamp(float const x, float const slope)
+{
+	AddResidual(residual, residual_pos, minblep_ramp, x, slope);
+}
+
+// take the minBLEP correction for the next sample
+__forceinline float OscillatorState::TakeResidual()
+{
+	float const value = residual[residual_pos];
+	residual[residual_pos] = 0.0f;
+	residual_pos = (residual_pos + 1) & (MINBLEP_TAPS - 1);
+	return value;
+}
+
+// advance the oscillator phase with hard sync selected at compile time
+template <bool SYNC> __forceinline void OscillatorState::Advance(OscillatorConfig const &config, float delta)
+{
+	phase += delta;
+	int const advance = FloorInt(phase);
+	if (advance)
+	{
+		// wrap phase around
+		phase -= advance;
+
+		// advance the wavetable index
+		index += advance;
+		if (index >= int(config.cycle))
+			index -= int(config.cycle);
+		else if (index < 0)
+			index += int(config.cycle);
+	}
+	if (SYNC)
+	{
+		if (phase >= config.sync_phase - index)
+		{
+			phase -= config.sync_phase - index;
+			index = 0;
+		}
+	}
+}
+
+// render a block of oscillator output and add it to the buffer
+// EVALUATE: wave evaluator specialized for the antialias and sync settings
+// limit: highest phase step the wave can represent (the wave is silent above it)
+template <float EVALUATE(OscillatorConfig const &config, OscillatorState &state, float step), bool SYNC>
+__forceinline void RenderWave(OscillatorConfig const &config, OscillatorState &state, float const delta, float const limit, float buffer[], size_t const count)
+{
+	// work on a local copy of the state
+	OscillatorState local(state);
+
+	if (delta > limit)
+	{
+		// only advance the phase
+		for (size_t i = 0; i < count; ++i)
+			local.Advance<SYNC>(config, delta);
+	}
+	else
+	{
+		// ramp amplitude across the block
+		float amplitude = config.amplitude_begin;
+		float const amplitude_step = (config.amplitude - config.amplitude_begin) / count;
+		for (size_t i = 0; i < count; ++i)
+		{
+			amplitude += amplitude_step;
+			buffer[i] += amplitude * EVALUATE(config, local, delta);
+			local.Advance<SYNC>(config, delta);
+		}
+	}
+
+	state = local;
+}
+
+// render a block of minBLEP oscillator output and add it to the buffer
+// (hard sync is not supported)
+// EVALUATE: naive wave value, offset by -slope * minblep_delay
+// CORRECT: adds corrections for discontinuities crossed while the phase
+// advanced from the given phase by delta
+// limit: highest phase step the wave can represent (the wave is silent above it)
+template <float EVALUATE(OscillatorConfig const &config, OscillatorState &state, float delta), void CORRECT(OscillatorConfig const &config, OscillatorState &state, float phase, float delta)>
+__forceinline void RenderWaveMinBLEP(OscillatorConfig const &config, OscillatorState &state, float const delta, float const limit, float buffer[], size_t const count)
+{
+	// work on a local copy of the state
+	OscillatorState local(state);
+
+	if (delta > limit)
+	{
+		// only advance the phase and drop pending corrections
+		for (size_t i = 0; i < count; ++i)
+			local.Advance<false>(config, delta);
+		memset(local.residual, 0, sizeof(local.residual));
+	}
+	else
+	{
+		// ramp amplitude across the block
+		float amplitude = config.amplitude_begin;
+		float const amplitude_step = (config.amplitude - config.amplitude_begin) / count;
+		for (size_t i = 0; i < count; ++i)
+		{
+			amplitude += amplitude_step;
+			buffer[i] += amplitude * (EVALUATE(config, local, delta) + local.TakeResidual());
+			float const phase = local.phase;
+			local.Advance<false>(config, delta);
+			CORRECT(config, local, phase, delta);
+		}
+	}
+
+	state = local;
+}
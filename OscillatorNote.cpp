@@ -8,6 +8,7 @@ Note Oscillator
 
 #include "OscillatorNote.h"
 #include "Voice.h"
+#include "Math.h"
 
 // note oscillator config
 NoteOscillatorConfig osc_config[NUM_OSCILLATORS];
@@ -15,7 +16,8 @@ NoteOscillatorConfig osc_config[NUM_OSCILLATORS];
 // TO DO: oscillator mixer
 
 // note oscillator state
-OscillatorState osc_state[VOICES][NUM_OSCILLATORS];
+// (allocated from the voice pool)
+OscillatorState (*osc_state)[NUM_OSCILLATORS];
 
 // modulate note oscillator
 void NoteOscillatorConfig::Modulate(float lfo)
@@ -24,8 +26,39 @@ void NoteOscillatorConfig::Modulate(float lfo)
 	waveparam = waveparam_base + waveparam_lfo * lfo;
 
 	// LFO frequency modulation
-	frequency = powf(2.0f, frequency_base + frequency_lfo * lfo);
+	frequency = FastExp2(frequency_base + frequency_lfo * lfo);
 
 	// LFO amplitude modulation
 	amplitude = amplitude_base + amplitude_lfo * lfo;
 }
+
+// render a block of note oscillator output
+void RenderNoteOscillator(NoteOscillatorConfig const &config, OscillatorState &state, float const step, float buffer[], size_t const count)
+{
+	// work on a local copy of the state
+	OscillatorState local(state);
+
+	// phase step is constant over the block
+	float const delta = config.frequency * config.adjust * step;
+
+	if (config.sub_osc_mode && config.sub_osc_amplitude)
+	{
+		// ramp amplitude across the block
+		float amplitude = config.amplitude_begin;
+		float const amplitude_step = (config.amplitude - config.amplitude_begin) / count;
+		for (size_t i = 0; i < count; ++i)
+		{
+			amplitude += amplitude_step;
+			float const sub_value = config.sub_osc_amplitude * SubOscillator(config, local, step);
+			buffer[i] += sub_value + amplitude * config.evaluate(config, local, delta);
+			local.Advance(config, delta);
+		}
+	}
+	else
+	{
+		// use the block renderer specialized for the current settings
+		GetWaveRender(config)(config, local, delta, buffer, count);
+	}
+
+	state = local;
+}
@@ -56,4 +56,8 @@ extern NoteOscillatorConfig osc_config[NUM_OSCILLATORS];
 // TO DO: oscillator mixer
 
 // note oscillator state
-extern OscillatorState osc_state[][NUM_OSCILLATORS];
+extern OscillatorState (*osc_state)[NUM_OSCILLATORS];
+
+// render a block of note oscillator output
+// (adds to the values already in the buffer)
+extern void RenderNoteOscillator(NoteOscillatorConfig const &config, OscillatorState &state, float const step, float buffer[], size_t const count);
@@ -0,0 +1,153 @@
+/*
+MINI VIRTUAL ANALOG SYNTHESIZER
+Copyright 2014 Kenneth D. Miller III
+
+Polyphase Half-Band Oversampler
+*/
+#include "StdAfx.h"
+
+#include "Oversampler.h"
+#include "Math.h"
+
+// half-band FIR branch coefficients, doubled
+// (equiripple designs; the taps of each branch sum to one half)
+
+// first stage: passband to 0.2 of the oversampled rate, 57 dB rejection
+static float const halfband_steep[8] =
+{
+	0.631356176f, -0.196835529f, 0.103044518f, -0.059563239f, 0.034413113f, -0.0188504407f, 0.00929686288f, -0.00421486911f
+};
+
+// second stage: passband to 0.1 of the oversampled rate, 89 dB rejection
+static float const halfband_wide[4] =
+{
+	0.606340785f, -0.13535739f, 0.0339309454f, -0.00494844682f
+};
+
+// symmetric FIR branch of a half-band filter
+// out[n] = sum of coeff[j] * (in[n + TAPS + j] + in[n + TAPS - 1 - j]) for j < TAPS
+// (each output lane sums its taps in the same order, so the SIMD and scalar
+// loops produce identical results)
+template <int TAPS> static __forceinline void HalfBandBranch(float const coeff[], float const in[], float out[], size_t const count)
+{
+	size_t n = 0;
+#if defined(__AVX2__)
+	for (; n + 8 <= count; n += 8)
+	{
+		__m256 sum = _mm256_setzero_ps();
+		for (int j = 0; j < TAPS; ++j)
+		{
+			__m256 const pair = _mm256_add_ps(_mm256_loadu_ps(in + n + TAPS + j), _mm256_loadu_ps(in + n + TAPS - 1 - j));
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(coeff[j]), pair));
+		}
+		_mm256_storeu_ps(out + n, sum);
+	}
+#endif
+#if _M_IX86_FP > 0
+	for (; n + 4 <= count; n += 4)
+	{
+		__m128 sum = _mm_setzero_ps();
+		for (int j = 0; j < TAPS; ++j)
+		{
+			__m128 const pair = _mm_add_ps(_mm_loadu_ps(in + n + TAPS + j), _mm_loadu_ps(in + n + TAPS - 1 - j));
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(coeff[j]), pair));
+		}
+		_mm_storeu_ps(out + n, sum);
+	}
+#endif
+	for (; n < count; ++n)
+	{
+		float sum = 0.0f;
+		for (int j = 0; j < TAPS; ++j)
+			sum += coeff[j] * (in[n + TAPS + j] + in[n + TAPS - 1 - j]);
+		out[n] = sum;
+	}
+}
+
+// upsample count samples to 2 * count samples
+// (the FIR branch produces the even outputs and the delay the odd outputs)
+template <int TAPS> static void Interpolate(float history[], float const coeff[], float const in[], float out[], size_t const count)
+{
+	int const HISTORY = 2 * TAPS - 1;
+
+	// input with the history in front
+	float buffer[HALFBAND_HISTORY + 2 * OVERSAMPLE_BLOCK];
+	memcpy(buffer, history, HISTORY * sizeof(float));
+	memcpy(buffer + HISTORY, in, count * sizeof(float));
+
+	float even[2 * OVERSAMPLE_BLOCK];
+	HalfBandBranch<TAPS>(coeff, buffer, even, count);
+	for (size_t n = 0; n < count; ++n)
+	{
+		out[2 * n] = even[n];
+		out[2 * n + 1] = buffer[n + TAPS];
+	}
+
+	memcpy(history, buffer + count, HISTORY * sizeof(float));
+}
+
+// downsample 2 * count samples to count samples
+// (the FIR branch filters the even inputs and the delay passes the odd inputs)
+template <int TAPS> static void Decimate(float even_history[], float odd_history[], float const coeff[], float const in[], float out[], size_t const count)
+{
+	int const HISTORY = 2 * TAPS - 1;
+
+	// split the input into even and odd samples with the history in front
+	float even[HALFBAND_HISTORY + 2 * OVERSAMPLE_BLOCK];
+	float odd[HALFBAND_HISTORY + 2 * OVERSAMPLE_BLOCK];
+	memcpy(even, even_history, HISTORY * sizeof(float));
+	memcpy(odd, odd_history, HISTORY * sizeof(float));
+	for (size_t n = 0; n < count; ++n)
+	{
+		even[HISTORY + n] = in[2 * n];
+		odd[HISTORY + n] = in[2 * n + 1];
+	}
+
+	float branch[2 * OVERSAMPLE_BLOCK];
+	HalfBandBranch<TAPS>(coeff, even, branch, count);
+	for (size_t n = 0; n < count; ++n)
+		out[n] = 0.5f * (odd[n + TAPS - 1] + branch[n]);
+
+	memcpy(even_history, even + count, HISTORY * sizeof(float));
+	memcpy(odd_history, odd + count, HISTORY * sizeof(float));
+}
+
+// clear the history
+void Oversampler::Reset()
+{
+	memset(up, 0, sizeof(up));
+	memset(down_even, 0, sizeof(down_even));
+	memset(down_odd, 0, sizeof(down_odd));
+}
+
+// upsample by the factor
+void Oversampler::Upsample(int const factor, float const in[], float out[], size_t const count)
+{
+	assert(count <= OVERSAMPLE_BLOCK);
+	if (factor == 4)
+	{
+		float twice[2 * OVERSAMPLE_BLOCK];
+		Interpolate<ARRAY_SIZE(halfband_steep)>(up[0], halfband_steep, in, twice, count);
+		Interpolate<ARRAY_SIZE(halfband_wide)>(up[1], halfband_wide, twice, out, 2 * count);
+	}
+	else
+	{
+		Interpolate<ARRAY_SIZE(halfband_steep)>(up[0], halfband_steep, in, out, count);
+	}
+}
+
+// downsample by the factor
+void Oversampler::Downsample(int const factor, float const in[], float out[], size_t const count)
+{
+	assert(count <= OVERSAMPLE_BLOCK);
+	if (factor == 4)
+	{
+		float twice[2 * OVERSAMPLE_BLOCK];
+		Decimate<ARRAY_SIZE(halfband_wide)>(down_even[1], down_odd[1], halfband_wide, in, twice, 2 * count);
+		Decimate<ARRAY_SIZE(halfband_steep)>(down_even[0], down_odd[0], halfband_steep, twice, out, count);
+	}
+	else
+	{
+		Decimate<ARRAY_SIZE(halfband_steep)>(down_even[0], down_odd[0], halfband_steep, in, out, count);
+	}
+}
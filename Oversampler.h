@@ -0,0 +1,52 @@
+#pragma once
+/*
+MINI VIRTUAL ANALOG SYNTHESIZER
+Copyright 2014 Kenneth D. Miller III
+
+Polyphase Half-Band Oversampler
+*/
+
+// The oversampler runs a nonlinear process at two or four times the sample
+// rate.  Each factor of two is a half-band FIR stage: the interpolator fills
+// in the samples between input samples and removes the images, and the
+// decimator removes everything above the original Nyquist frequency before
+// dropping every other sample.  Every other tap of a half-band filter is zero
+// except the center tap of one half, so each stage splits into a symmetric FIR
+// branch and a pure delay.  The first stage is steep (about 57 dB of
+// rejection above 0.4 of the sample rate); the second stage only has to clean
+// up above the first stage's band and gets by with half the taps.  The FIR
+// branches compute several outputs at a time with SIMD.
+
+// most base-rate samples per call
+#define OVERSAMPLE_BLOCK 64
+
+// largest oversampling factor
+#define OVERSAMPLE_MAX 4
+
+// input history each half-band branch keeps between blocks
+#define HALFBAND_HISTORY 15
+
+class Oversampler
+{
+public:
+	// input history for each interpolator stage
+	float up[2][HALFBAND_HISTORY];
+
+	// even and odd input history for each decimator stage
+	float down_even[2][HALFBAND_HISTORY];
+	float down_odd[2][HALFBAND_HISTORY];
+
+	Oversampler()
+	{
+		Reset();
+	}
+	void Reset();
+
+	// upsample count samples by the factor (2 or 4)
+	// (count must not exceed OVERSAMPLE_BLOCK)
+	void Upsample(int const factor, float const in[], float out[], size_t const count);
+
+	// downsample count * factor samples by the factor (2 or 4)
+	// (count must not exceed OVERSAMPLE_BLOCK)
+	void Downsample(int const factor, float const in[], float out[], size_t const count);
+};
@@ -0,0 +1,344 @@
+/*
+MINI VIRTUAL ANALOG SYNTHESIZER
+Copyright 2014 Kenneth D. Miller III
+
+Patch Files
+*/
+#include "StdAfx.h"
+
+#include <ctype.h>
+
+#include "Patch.h"
+#include "Math.h"
+#include "Wave.h"
+#include "OscillatorNote.h"
+#include "OscillatorLFO.h"
+#include "SubOscillator.h"
+#include "Filter.h"
+#include "Amplifier.h"
+#include "Render.h"
+
+namespace Patch
+{
+	// case-insensitive string comparison
+	static bool Match(char const *a, char const *b)
+	{
+		while (*a && *b)
+		{
+			if (tolower((unsigned char)(*a)) != tolower((unsigned char)(*b)))
+				return false;
+			++a, ++b;
+		}
+		return *a == *b;
+	}
+
+	// parse a boolean value
+	static bool ParseBool(char const *text, bool &value)
+	{
+		if (Match(text, "on") || Match(text, "true") || Match(text, "1"))
+			value = true;
+		else if (Match(text, "off") || Match(text, "false") || Match(text, "0"))
+			value = false;
+		else
+			return false;
+		return true;
+	}
+
+	// parse a floating-point value
+	static bool ParseFloat(char const *text, float &value)
+	{
+		char *end;
+		double const result = strtod(text, &end);
+		if (end == text || *end)
+			return false;
+		value = float(result);
+		return true;
+	}
+
+	// parse an enumerated value by name or index
+	static bool ParseName(char const *text, char const * const names[], int const count, int &value)
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			if (Match(text, names[i]))
+			{
+				value = i;
+				return true;
+			}
+		}
+		char *end;
+		long const index = strtol(text, &end, 10);
+		if (end == text || *end || index < 0 || index >= count)
+			return false;
+		value = int(index);
+		return true;
+	}
+
+	// parse an envelope time and update its rate
+	static bool ParseTime(char const *text, float &time, float &rate)
+	{
+		if (!ParseFloat(text, time))
+			return false;
+		time = Max(time, 0.0f);
+		rate = 1.0f / (time + FLT_MIN);
+		return true;
+	}
+
+	// apply a note oscillator setting
+	static bool SetOscillator(NoteOscillatorConfig &config, char const *name, char const *value)
+	{
+		int index;
+		if (Match(name, "enable"))
+			return ParseBool(value, config.enable);
+		if (Match(name, "wave"))
+		{
+			if (!ParseName(value, wave_name, WAVE_COUNT, index))
+				return false;
+			config.SetWaveType(Wave(index));
+			return true;
+		}
+		if (Match(name, "width"))
+			return ParseFloat(value, config.waveparam_base);
+		if (Match(name, "frequency"))
+			return ParseFloat(value, config.frequency_base);
+		if (Match(name, "amplitude"))
+			return ParseFloat(value, config.amplitude_base);
+		if (Match(name, "width_lfo"))
+			return ParseFloat(value, config.waveparam_lfo);
+		if (Match(name, "frequency_lfo"))
+			return ParseFloat(value, config.frequency_lfo);
+		if (Match(name, "amplitude_lfo"))
+			return ParseFloat(value, config.amplitude_lfo);
+		if (Match(name, "key_follow"))
+			return ParseFloat(value, config.key_follow);
+		if (Match(name, "sub_osc"))
+		{
+			if (!ParseName(value, sub_osc_name, SUBOSC_COUNT, index))
+				return false;
+			config.sub_osc_mode = SubOscillatorMode(index);
+			return true;
+		}
+		if (Match(name, "sub_amplitude"))
+			return ParseFloat(value, config.sub_osc_amplitude);
+		if (Match(name, "sync"))
+			return ParseBool(value, config.sync_enable);
+		return false;
+	}
+
+	// apply a low-frequency oscillator setting
+	static bool SetLFO(char const *name, char const *value)
+	{
+		int index;
+		if (Match(name, "enable"))
+			return ParseBool(value, lfo_config.enable);
+		if (Match(name, "wave"))
+		{
+			if (!ParseName(value, wave_name, WAVE_COUNT, index))
+				return false;
+			lfo_config.SetWaveType(Wave(index));
+			return true;
+		}
+		if (Match(name, "width"))
+			return ParseFloat(value, lfo_config.waveparam);
+		if (Match(name, "frequency"))
+		{
+			if (!ParseFloat(value, lfo_config.frequency_base))
+				return false;
+			lfo_config.frequency = powf(2.0f, lfo_config.frequency_base);
+			return true;
+		}
+		return false;
+	}
+
+	// apply a filter setting
+	static bool SetFilter(char const *name, char const *value)
+	{
+		int index;
+		if (Match(name, "enable"))
+		{
+			if (!ParseBool(value, flt_config.enable))
+				return false;
+			flt_env_config.enable = flt_config.enable;
+			return true;
+		}
+		if (Match(name, "model"))
+		{
+			if (!ParseName(value, filter_model_name, FILTER_MODEL_COUNT, index))
+				return false;
+			flt_config.model = FilterModel(index);
+			return true;
+		}
+		if (Match(name, "oversample"))
+		{
+			if (Match(value, "auto"))
+			{
+				flt_config.oversample = 0;
+				return true;
+			}
+			char *end;
+			long const factor = strtol(value, &end, 10);
+			if (end == value || *end || (factor != 1 && factor != 2 && factor != 4))
+				return false;
+			flt_config.oversample = int(factor);
+			return true;
+		}
+		if (Match(name, "mode"))
+		{
+			if (!ParseName(value, filter_name, FilterConfig::COUNT, index))
+				return false;
+			flt_config.SetMode(FilterConfig::Mode(index));
+			return true;
+		}
+		if (Match(name, "drive"))
+			return ParseFloat(value, flt_config.drive);
+		if (Match(name, "compensation"))
+			return ParseFloat(value, flt_config.compensation);
+		if (Match(name, "resonance"))
+			return ParseFloat(value, flt_config.resonance);
+		if (Match(name, "cutoff"))
+			return ParseFloat(value, flt_config.cutoff_base);
+		if (Match(name, "cutoff_lfo"))
+			return ParseFloat(value, flt_config.cutoff_lfo);
+		if (Match(name, "cutoff_env"))
+			return ParseFloat(value, flt_config.cutoff_env);
+		if (Match(name, "cutoff_vel"))
+			return ParseFloat(value, flt_config.cutoff_env_vel);
+		if (Match(name, "key_follow"))
+			return ParseFloat(value, flt_config.key_follow);
+		if (Match(name, "attack"))
+			return ParseTime(value, flt_env_config.attack_time, flt_env_config.attack_rate);
+		if (Match(name, "decay"))
+			return ParseTime(value, flt_env_config.decay_time, flt_env_config.decay_rate);
+		if (Match(name, "sustain"))
+			return ParseFloat(value, flt_env_config.sustain_level);
+		if (Match(name, "release"))
+			return ParseTime(value, flt_env_config.release_time, flt_env_config.release_rate);
+		return false;
+	}
+
+	// apply an amplifier setting
+	static bool SetAmplifier(char const *name, char const *value)
+	{
+		if (Match(name, "enable"))
+			return ParseBool(value, amp_env_config.enable);
+		if (Match(name, "level_env"))
+			return ParseFloat(value, amp_config.level_env);
+		if (Match(name, "level_vel"))
+			return ParseFloat(value, amp_config.level_env_vel);
+		if (Match(name, "attack"))
+			return ParseTime(value, amp_env_config.attack_time, amp_env_config.attack_rate);
+		if (Match(name, "decay"))
+			return ParseTime(value, amp_env_config.decay_time, amp_env_config.decay_rate);
+		if (Match(name, "sustain"))
+			return ParseFloat(value, amp_env_config.sustain_level);
+		if (Match(name, "release"))
+			return ParseTime(value, amp_env_config.release_time, amp_env_config.release_rate);
+		return false;
+	}
+
+	// apply a global setting
+	static bool SetGlobal(char const *name, char const *value)
+	{
+		if (Match(name, "antialias"))
+		{
+			// on/off, or the method to use
+			if (Match(value, "polyblep"))
+			{
+				SetAntialias(ANTIALIAS_POLYBLEP);
+				return true;
+			}
+			if (Match(value, "minblep"))
+			{
+				SetAntialias(ANTIALIAS_MINBLEP);
+				return true;
+			}
+			if (Match(value, "wavetable"))
+			{
+				SetAntialias(ANTIALIAS_WAVETABLE);
+				return true;
+			}
+			return ParseBool(value, use_antialias);
+		}
+		if (Match(name, "output"))
+			return ParseFloat(value, output_scale);
+		return false;
+	}
+
+	// apply one setting
+	static bool Set(char *key, char const *value)
+	{
+		char *name = strchr(key, '.');
+		if (!name)
+			return SetGlobal(key, value);
+		*name++ = '\0';
+
+		// oscillator sections are numbered from 1
+		if (strlen(key) == 4 && isdigit((unsigned char)(key[3])))
+		{
+			int const o = key[3] - '1';
+			key[3] = '\0';
+			if (Match(key, "osc") && o >= 0 && o < NUM_OSCILLATORS)
+				return SetOscillator(osc_config[o], name, value);
+			return false;
+		}
+		if (Match(key, "lfo"))
+			return SetLFO(name, value);
+		if (Match(key, "flt"))
+			return SetFilter(name, value);
+		if (Match(key, "amp"))
+			return SetAmplifier(name, value);
+		return false;
+	}
+
+	// trim leading and trailing whitespace in place
+	static char *Trim(char *text)
+	{
+		while (isspace((unsigned char)(*text)))
+			++text;
+		char *end = text + strlen(text);
+		while (end > text && isspace((unsigned char)(end[-1])))
+			--end;
+		*end = '\0';
+		return text;
+	}
+
+	// load settings from a patch file
+	bool Load(char const *filename)
+	{
+		FILE *file = fopen(filename, "r");
+		if (!file)
+		{
+			fprintf(stderr, "%s: cannot open patch\n", filename);
+			return false;
+		}
+
+		bool ok = true;
+		char line[256];
+		for (int number = 1; fgets(line, sizeof(line), file); ++number)
+		{
+			char *text = Trim(line);
+			if (!*text || *text == '#' || *text == ';')
+				continue;
+
+			char *value = strchr(text, '=');
+			if (!value)
+			{
+				fprintf(stderr, "%s(%d): expected name = value\n", filename, number);
+				ok = false;
+				continue;
+			}
+			*value++ = '\0';
+
+			char *key = Trim(text);
+			value = Trim(value);
+			if (!Set(key, value))
+			{
+				fprintf(stderr, "%s(%d): invalid setting \"%s = %s\"\n", filename, number, key, value);
+				ok = false;
+			}
+		}
+
+		fclose(file);
+		return ok;
+	}
+}
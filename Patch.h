@@ -0,0 +1,29 @@
+#pragma once
+/*
+MINI VIRTUAL ANALOG SYNTHESIZER
+Copyright 2014 Kenneth D. Miller III
+
+Patch Files
+*/
+
+// Patch files are plain text with one "section.name = value" setting per
+// line.  Lines starting with '#' or ';' are comments.  Settings use the same
+// units as the synthesizer internals: pitch and cutoff offsets in octaves,
+// levels and widths as fractions, and envelope times in seconds.  Wave types,
+// filter modes, and sub-oscillator modes take a name or an index.  The
+// global antialias setting takes on, off, polyblep, minblep, or wavetable.
+// The filter oversample setting takes auto, 1, 2, or 4.
+//
+// osc1.enable = on
+// osc1.wave = Sawtooth
+// flt.enable = on
+// flt.mode = Low-Pass 4
+// flt.cutoff = 2.5
+// amp.release = 0.25
+
+namespace Patch
+{
+	// load settings from a patch file
+	// (settings not present in the file keep their current values)
+	extern bool Load(char const *filename);
+}
@@ -78,6 +78,39 @@ inline float PolyBLEP(float t, float w)
 	return tt1 + t + t;
 }
 
+// PolyBLEP by integration
+// The quadratic PolyBLEP above is exactly a triangular filter of half-width w
+// applied to the naive wave.  For a wave of held samples, the same filter is a
+// second difference of the wave's second integral S2:
+//     (S2(x + w) - 2 * S2(x) + S2(x - w)) / w^2
+// which costs three lookups no matter how many steps fall inside the window.
+// Waves that support it keep running sums to look up S2 at sample boundaries.
+
+// twice the second integral of a periodic held-sample wave
+// at q periods plus r samples plus fraction f, with r inside the period
+// (positions need double precision: the integral's slope grows with the
+// running sum, so float rounding of the position swamps the result)
+// sum: running sum of samples before r
+// sum2: twice the running sum of those running sums before r
+// value: sample at r
+// total, total2: sum and sum2 over a full period
+inline double HeldIntegral(int const q, int const r, double const f, double sum, double sum2, float const value, int const length, double const total, double const total2)
+{
+	// add the whole periods before the position
+	if (q)
+	{
+		sum2 += q * (total2 + total * (double(length) * (q - 1) + 2.0 * r));
+		sum += q * total;
+	}
+	return sum2 + f * (sum + sum + f * value);
+}
+
+// triangular filter of half-width w from HeldIntegral at x - w, x, and x + w
+inline float HeldFilter(double const before, double const at, double const after, float const w)
+{
+	return float((before - at - at + after) / (2.0 * w * w));
+}
+
 // IntegratedPolyBLEP
 // Polynomial correction for C1 (slope) discontinuity
 
@@ -6,10 +6,48 @@ Random Number Generator
 */
 #include "StdAfx.h"
 
+#if _M_IX86_FP > 0
+#include <emmintrin.h>
+#endif
+
 #include "Random.h"
 
 namespace Random
 {
 	// random seed
 	unsigned int gSeed = 0x92D68CA2;
+
+	// fill a buffer with random uniform floats
+	void Stream::Fill(float buffer[], size_t count)
+	{
+		size_t i = 0;
+
+		// single values up to the first generator
+		while (i < count && (position & 3))
+			buffer[i++] = Float();
+
+#if _M_IX86_FP > 0
+		// four values at a time
+		if (i + 4 <= count)
+		{
+			__m128i x = _mm_loadu_si128(reinterpret_cast<__m128i const *>(lane));
+			__m128i const one = _mm_set1_epi32(0x3f800000);
+			__m128 const bias = _mm_set1_ps(1.0f);
+			for (; i + 4 <= count; i += 4)
+			{
+				x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+				x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+				x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+				__m128 const f = _mm_castsi128_ps(_mm_or_si128(one, _mm_srli_epi32(x, 9)));
+				_mm_storeu_ps(buffer + i, _mm_sub_ps(f, bias));
+				position += 4;
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(lane), x);
+		}
+#endif
+
+		// remaining single values
+		while (i < count)
+			buffer[i++] = Float();
+	}
 }
@@ -40,4 +40,56 @@ namespace Random
 		floatint.u = 0x3f800000 | (Int() >> 9);
 		return floatint.f - 1.0f;
 	}
+
+	// hash two values into a seed
+	// (murmur3 finalizer)
+	inline unsigned int Hash(unsigned int a, unsigned int b)
+	{
+		unsigned int h = a * 0x9E3779B9 ^ b;
+		h ^= h >> 16;
+		h *= 0x85EBCA6B;
+		h ^= h >> 13;
+		h *= 0xC2B2AE35;
+		h ^= h >> 16;
+		return h;
+	}
+
+	// independent random number stream
+	// (four interleaved 32-bit xor-shift generators so blocks can be filled
+	// four values at a time with SIMD; value n always comes from generator
+	// n % 4, so single values and blocks give the same sequence)
+	struct Stream
+	{
+		unsigned int lane[4];
+		unsigned int position;
+
+		// seed the generators from a key
+		void Seed(unsigned int key)
+		{
+			for (unsigned int i = 0; i < 4; ++i)
+				lane[i] = Hash(key, i) | 1;
+			position = 0;
+		}
+
+		// random unsigned integer
+		unsigned int Int()
+		{
+			unsigned int &x = lane[position++ & 3];
+			x ^= (x << 13);
+			x ^= (x >> 17);
+			x ^= (x << 5);
+			return x;
+		}
+
+		// random uniform float
+		float Float()
+		{
+			union { float f; unsigned u; } floatint;
+			floatint.u = 0x3f800000 | (Int() >> 9);
+			return floatint.f - 1.0f;
+		}
+
+		// fill a buffer with random uniform floats
+		void Fill(float buffer[], size_t count);
+	};
 }
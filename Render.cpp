@@ -0,0 +1,394 @@
+/*
+MINI VIRTUAL ANALOG SYNTHESIZER
+Copyright 2014 Kenneth D. Miller III
+
+Sample Rendering
+*/
+#include "StdAfx.h"
+
+#include "Render.h"
+#include "Math.h"
+#include "Voice.h"
+#include "OscillatorLFO.h"
+#include "OscillatorNote.h"
+#include "SubOscillator.h"
+#include "Filter.h"
+#include "Amplifier.h"
+#include "VoiceBank.h"
+#include "RenderPool.h"
+#include "EventQueue.h"
+#include "Snapshot.h"
+
+// output scale factor
+float output_scale = 0.25f;	// 0.25f;
+
+// samples per control update
+size_t control_samples = DEFAULT_CONTROL_SAMPLES;
+
+// silence threshold in dBFS
+float silence_db = DEFAULT_SILENCE_DB;
+
+// oscillator amplitudes at the end of the previous control update
+// (starts at the default oscillator amplitude)
+static float osc_amplitude[NUM_OSCILLATORS] = { 1.0f, 1.0f };
+
+// apply low-frequency oscillator value
+static void ApplyLFO(float lfo)
+{
+	Snapshot &patch = *render_snapshot;
+
+	// compute shared oscillator values
+	for (int o = 0; o < NUM_OSCILLATORS; ++o)
+	{
+		patch.osc_config[o].Modulate(lfo);
+	}
+
+	// set up sync phases
+	for (int o = 1; o < NUM_OSCILLATORS; ++o)
+	{
+		if (patch.osc_config[o].sync_enable)
+			patch.osc_config[o].sync_phase = patch.osc_config[o].frequency / patch.osc_config[0].frequency;
+	}
+}
+
+// render a control block for one voice and add it to the bus
+// (returns the number of samples rendered before the amplifier envelope finished;
+// peak receives the largest output magnitude)
+static size_t RenderVoice(int const v, NoteOscillatorConfig const config[NUM_OSCILLATORS], float const osc_key_freq[NUM_OSCILLATORS], float const flt_key_freq, float const lfo, float const step, float bus[], size_t const samples, float &peak)
+{
+	peak = 0.0f;
+
+	Snapshot const &patch = *render_snapshot;
+
+	// update volume envelope generator
+	float amp_env_amplitude[MAX_CONTROL_SAMPLES];
+	size_t const voice_samples = amp_env_state[v].Render(patch.amp_env_config, step, amp_env_amplitude, samples);
+
+	// if the envelope generator finished...
+	if (voice_samples == 0)
+		return 0;
+
+	// key velocity
+	float const key_vel = voice_vel[v] / 64.0f;
+
+	// update oscillators
+	// (assume key follow)
+	float osc_value[MAX_CONTROL_SAMPLES] = { 0 };
+	for (int o = 0; o < NUM_OSCILLATORS; ++o)
+	{
+		if (!config[o].enable)
+			continue;
+		float const key_step = osc_key_freq[o] * step;
+		RenderNoteOscillator(config[o], osc_state[v][o], key_step, osc_value, voice_samples);
+	}
+
+	// update filter
+	if (patch.flt_config.enable)
+	{
+		// update filter envelope generator
+		float const flt_env_amplitude = flt_env_state[v].Update(patch.flt_env_config, step * samples);
+
+		// compute cutoff frequency
+		float const cutoff = flt_key_freq * patch.flt_config.GetCutoff(lfo, flt_env_amplitude, key_vel);
+
+		// ramp the filter to the new cutoff over the block
+		flt_state[v].Ramp(patch.flt_config, cutoff, patch.flt_config.resonance, step, samples);
+
+		// get filtered oscillator values
+		flt_state[v].Render(patch.flt_config, osc_value, voice_samples);
+	}
+
+	// apply amplifier level and accumulate result
+	for (size_t s = 0; s < voice_samples; ++s)
+	{
+		float const value = osc_value[s] * patch.amp_config.GetLevel(amp_env_amplitude[s], key_vel);
+		bus[s] += value;
+		peak = Max(peak, fabsf(value));
+	}
+
+	return voice_samples;
+}
+
+// most control blocks within a chunk
+static size_t const CHUNK_BLOCKS = RENDER_CHUNK_SAMPLES / MIN_CONTROL_SAMPLES;
+
+// most voices rendered by one task
+#if VOICE_BANK
+static int const MAX_TASK_VOICES = VOICE_BANK_LANES;
+#else
+static int const MAX_TASK_VOICES = 1;
+#endif
+
+// values shared by the render tasks for a chunk
+struct Chunk
+{
+	// active voices
+	int index[MAX_VOICES];
+	int active;
+
+	// voices per task
+	int group;
+
+	// use the voice bank
+	bool bank;
+
+	// key frequencies
+	float osc_key_freq[MAX_VOICES][NUM_OSCILLATORS];
+	float flt_key_freq[MAX_VOICES];
+
+	// time step per output sample
+	float step;
+
+	// samples in the chunk
+	size_t count;
+
+	// silence threshold as a bus level
+	float silence;
+
+	// samples of quiet output needed to retire a voice
+	unsigned int quiet_window;
+
+	// low-frequency oscillator value and modulated oscillator configuration for each block
+	float lfo[CHUNK_BLOCKS];
+	NoteOscillatorConfig osc_config[CHUNK_BLOCKS][NUM_OSCILLATORS];
+};
+static Chunk chunk;
+
+// render a group of voices for the whole chunk
+static void RenderTask(int const task, float bus[], void *context)
+{
+	Chunk const &chunk = *static_cast<Chunk const *>(context);
+
+	// get the voices for this task
+	int voice[MAX_TASK_VOICES];
+	int count = 0;
+	for (int i = task * chunk.group; i < chunk.active && count < chunk.group; ++i)
+		voice[count++] = chunk.index[i];
+
+	// for each control block...
+	for (size_t b = 0, c = 0; c < chunk.count && count > 0; ++b, c += control_samples)
+	{
+		// samples in this block
+		size_t const samples = Min(chunk.count - c, control_samples);
+
+		// samples rendered by each voice and its peak output
+		size_t rendered[MAX_TASK_VOICES];
+		float peak[MAX_TASK_VOICES];
+
+#if VOICE_BANK
+		if (chunk.bank)
+		{
+			// render the voices in parallel
+			VoiceBankRender(voice, count, chunk.osc_config[b], chunk.osc_key_freq, chunk.flt_key_freq, chunk.lfo[b], chunk.step, bus + c, samples, rendered, peak);
+		}
+		else
+#endif
+		{
+			// render each voice
+			for (int i = 0; i < count; ++i)
+			{
+				int const v = voice[i];
+				rendered[i] = RenderVoice(v, chunk.osc_config[b], chunk.osc_key_freq[v], chunk.flt_key_freq[v], chunk.lfo[b], chunk.step, bus + c, samples, peak[i]);
+			}
+		}
+
+		// remove voices whose envelope generator finished or that stayed silent
+		int remain = 0;
+		for (int i = 0; i < count; ++i)
+		{
+			int const v = voice[i];
+			if (rendered[i] < samples)
+				continue;
+			if (peak[i] < chunk.silence && amp_env_state[v].IsFalling(render_snapshot->amp_env_config))
+			{
+				voice_quiet[v] += (unsigned int)(samples);
+				if (voice_quiet[v] >= chunk.quiet_window)
+				{
+					RetireVoice(v);
+					continue;
+				}
+			}
+			else
+			{
+				voice_quiet[v] = 0;
+			}
+			voice[remain++] = v;
+		}
+		count = remain;
+	}
+}
+
+// samples the whole output has stayed silent
+static unsigned int bus_quiet;
+
+// render a chunk of interleaved stereo output samples
+static void RenderChunk(float buffer[], size_t const count, float const step)
+{
+	// pick up patch changes from the user interface
+	// (the outgoing snapshot may be reused as soon as it is let go)
+	FilterModel const flt_model = render_snapshot->flt_config.model;
+	int const flt_oversample = render_snapshot->flt_config.GetOversample();
+	AcquireSnapshot();
+	Snapshot const &patch = *render_snapshot;
+
+	// filter state from another model or oversampling factor does not carry over
+	if (patch.flt_config.model != flt_model || patch.flt_config.GetOversample() != flt_oversample)
+	{
+		for (int v = 0; v < voice_count; ++v)
+			flt_state[v].Reset();
+	}
+
+	// get active voices
+	chunk.active = 0;
+	for (int v = 0; v < voice_count; v++)
+	{
+		if (amp_env_state[v].state != EnvelopeState::OFF)
+		{
+			chunk.index[chunk.active++] = v;
+		}
+	}
+
+	// for each active voice...
+	for (int i = 0; i < chunk.active; ++i)
+	{
+		// get the voice index
+		int const v = chunk.index[i];
+
+		// compute oscillator key frequency
+		for (int o = 0; o < NUM_OSCILLATORS; ++o)
+		{
+			chunk.osc_key_freq[v][o] = NoteFrequency(voice_note[v], patch.osc_config[o].key_follow);
+		}
+
+		// compute filter key frequency
+		chunk.flt_key_freq[v] = NoteFrequency(voice_note[v], patch.flt_config.key_follow);
+	}
+
+	// low-frequency oscillator value
+	// (updated once per control update)
+	float lfo = 0;
+
+	if (chunk.active == 0)
+	{
+		// nothing left to retire
+		bus_quiet = 0;
+
+		// clear buffer
+		memset(buffer, 0, count * 2 * sizeof(buffer[0]));
+
+		// get low-frequency oscillator value
+		if (patch.lfo_config.enable)
+			lfo = lfo_state.Update(patch.lfo_config, count * step);
+
+		// apply low-frequency oscillator
+		ApplyLFO(lfo);
+		for (int o = 0; o < NUM_OSCILLATORS; ++o)
+			osc_amplitude[o] = patch.osc_config[o].amplitude;
+
+		return;
+	}
+
+	// flush denormals
+	unsigned int const prev = FlushDenormals();
+
+	// if the low-frequency oscillator is off...
+	if (!patch.lfo_config.enable)
+	{
+		ApplyLFO(0);
+	}
+
+	// for each control block...
+	for (size_t b = 0, c = 0; c < count; ++b, c += control_samples)
+	{
+		// samples in this block
+		// (the last block may be short when the chunk ends at an event)
+		size_t const samples = Min(count - c, control_samples);
+
+		// apply low-frequency oscillator
+		if (patch.lfo_config.enable)
+		{
+			// get low-frequency oscillator value
+			lfo = lfo_state.Update(patch.lfo_config, step * samples);
+
+			// apply low-frequency oscillator
+			ApplyLFO(lfo);
+		}
+
+		// save control values for the block
+		// (oscillator amplitudes ramp from where the previous block ended)
+		chunk.lfo[b] = lfo;
+		for (int o = 0; o < NUM_OSCILLATORS; ++o)
+		{
+			chunk.osc_config[b][o] = patch.osc_config[o];
+			chunk.osc_config[b][o].amplitude_begin = osc_amplitude[o];
+			osc_amplitude[o] = patch.osc_config[o].amplitude;
+		}
+	}
+
+#if VOICE_BANK
+	// use the voice bank if the settings allow
+	chunk.bank = VoiceBankSupported();
+	chunk.group = chunk.bank ? VOICE_BANK_LANES : 1;
+#else
+	chunk.bank = false;
+	chunk.group = 1;
+#endif
+	chunk.step = step;
+	chunk.count = count;
+	chunk.silence = powf(10.0f, silence_db / 20.0f) / Max(output_scale, FLT_MIN);
+	chunk.quiet_window = (unsigned int)(Max(float(control_samples), SILENCE_WINDOW / step));
+
+	// render voices into the accumulated sample values
+	float bus[RENDER_CHUNK_SAMPLES] = { 0 };
+	int const tasks = (chunk.active + chunk.group - 1) / chunk.group;
+	RenderPool::Run(tasks, RenderTask, &chunk, bus, count);
+
+	// left and right channels are the same
+	float peak = 0.0f;
+	for (size_t s = 0; s < count; ++s)
+	{
+		peak = Max(peak, fabsf(bus[s]));
+		float const output = bus[s] * output_scale;
+		*buffer++ = output;
+		*buffer++ = output;
+	}
+
+	// if the whole output stayed silent, retire every voice that can only fall
+	if (peak < chunk.silence)
+		bus_quiet += (unsigned int)(count);
+	else
+		bus_quiet = 0;
+	if (bus_quiet >= chunk.quiet_window)
+	{
+		for (int i = 0; i < chunk.active; ++i)
+		{
+			int const v = chunk.index[i];
+			if (amp_env_state[v].IsFalling(patch.amp_env_config))
+				RetireVoice(v);
+		}
+	}
+
+	// restore denormal
+	RestoreDenormals(prev);
+}
+
+// render interleaved stereo output samples
+void Render(float buffer[], size_t const count, float const step)
+{
+	// place note and controller events from the front ends within the buffer
+	EventQueue::Collect(count);
+
+	for (size_t c = 0; c < count;)
+	{
+		// apply events due at this sample and get the offset of the next one
+		size_t const next = EventQueue::Dispatch(c);
+
+		// render up to the next event
+		size_t const end = Min(Min(next, count), c + RENDER_CHUNK_SAMPLES);
+		RenderChunk(buffer + c * 2, end - c, step);
+		c = end;
+
+		// re-rank voices for stealing
+		UpdateVoices();
+	}
+}
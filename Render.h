@@ -0,0 +1,41 @@
+#pragma once
+/*
+MINI VIRTUAL ANALOG SYNTHESIZER
+Copyright 2014 Kenneth D. Miller III
+
+Sample Rendering
+*/
+
+// output scale factor
+extern float output_scale;
+
+// samples per control update
+// (low-frequency oscillator, filter envelope, and filter cutoff are evaluated
+// once per control update and ramped linearly across the samples in between)
+extern size_t control_samples;
+
+// control update range and default
+static size_t const MIN_CONTROL_SAMPLES = 4;
+static size_t const MAX_CONTROL_SAMPLES = 64;
+static size_t const DEFAULT_CONTROL_SAMPLES = 32;
+
+// silence threshold in dBFS
+// (voices that can only fall and whose output stays below this are retired
+// early, and when the whole output falls below it every such voice is)
+extern float silence_db;
+static float const DEFAULT_SILENCE_DB = -96.0f;
+
+// shortest run of quiet output that retires voices, in seconds
+// (never less than one control update; a short block near a zero crossing
+// can read as quiet even for a loud voice)
+static float const SILENCE_WINDOW = 0.005f;
+
+// samples per render chunk
+// (voices render a whole chunk at a time, possibly on worker threads)
+static size_t const RENDER_CHUNK_SAMPLES = 1024;
+
+// render interleaved stereo output samples
+// (shared by the audio stream callback and the offline renderer)
+// buffer: receives count * 2 samples
+// step: time step per output sample in seconds
+extern void Render(float buffer[], size_t const count, float const step);
@@ -0,0 +1,302 @@
+/*
+MINI VIRTUAL ANALOG SYNTHESIZER
+Copyright 2014 Kenneth D. Miller III
+
+Render Thread Pool
+*/
+#include "StdAfx.h"
+
+#include <atomic>
+#include <chrono>
+#ifndef WIN32
+#include <thread>
+#endif
+
+#include "RenderPool.h"
+#include "Math.h"
+
+namespace RenderPool
+{
+	// keep yielding for this long after a job before falling back to sleeping
+	static std::chrono::milliseconds const IDLE_SPIN_TIME(20);
+
+	// participants: the calling thread (0) followed by the worker threads
+	static int threads;
+	static size_t capacity;
+#ifdef WIN32
+	static HANDLE worker[MAX_THREADS];
+#else
+	static std::thread *worker[MAX_THREADS];
+#endif
+
+	// private participant buffers and the job generation they belong to
+	static float *participant_buffer[MAX_THREADS + 1];
+	static unsigned int participant_generation[MAX_THREADS + 1];
+
+	// job generation
+	// (incremented to publish each job)
+	static std::atomic<unsigned int> generation;
+
+	// stop request
+	static std::atomic<bool> quit;
+
+	// current job
+	static Task job_task;
+	static void *job_context;
+	static size_t job_count;
+
+	// number of tasks completed in the current job
+	static std::atomic<int> completed;
+
+	// each participant's range of tasks
+	// (the job generation, end, and next task share one word so a stale
+	// worker can never pair one job's range with another job's generation)
+	static std::atomic<unsigned long long> range[MAX_THREADS + 1];
+
+	// pack a participant's range
+	static unsigned long long PackRange(unsigned int const gen, int const end, int const next)
+	{
+		return ((unsigned long long)(gen) << 32) | ((unsigned long long)(end) << 16) | (unsigned long long)(next);
+	}
+
+	// claim a task from a participant's range
+	// (returns -1 if the range is empty or belongs to another job)
+	static int Claim(int const owner, unsigned int const gen)
+	{
+		unsigned long long value = range[owner].load(std::memory_order_acquire);
+		for (;;)
+		{
+			if ((unsigned int)(value >> 32) != gen)
+				return -1;
+			int const task = int(value & 0xFFFF);
+			if (task >= int((value >> 16) & 0xFFFF))
+				return -1;
+			if (range[owner].compare_exchange_weak(value, value + 1, std::memory_order_acq_rel))
+				return task;
+		}
+	}
+
+	// run tasks from the participant's own range, then steal from the others
+	static void Work(int const self, unsigned int const gen)
+	{
+		int const participants = threads + 1;
+		for (int i = 0; i < participants; ++i)
+		{
+			int const owner = (self + i) % participants;
+			for (int task = Claim(owner, gen); task >= 0; task = Claim(owner, gen))
+			{
+				// clear the private buffer on the first task of the job
+				float *buffer = participant_buffer[self];
+				if (participant_generation[self] != gen)
+				{
+					memset(buffer, 0, job_count * sizeof(buffer[0]));
+					participant_generation[self] = gen;
+				}
+
+				job_task(task, buffer, job_context);
+				completed.fetch_add(1, std::memory_order_release);
+			}
+		}
+	}
+
+	// yield the rest of the time slice
+	static void Relax()
+	{
+#ifdef WIN32
+		SwitchToThread();
+#else
+		std::this_thread::yield();
+#endif
+	}
+
+	// sleep for about a millisecond
+	static void Nap()
+	{
+#ifdef WIN32
+		Sleep(1);
+#else
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+	}
+
+	// worker thread
+	static void Worker(int const self)
+	{
+		// render threads always flush denormals
+		FlushDenormals();
+
+		unsigned int seen = generation.load(std::memory_order_acquire);
+		std::chrono::steady_clock::time_point idle = std::chrono::steady_clock::now();
+		while (!quit.load(std::memory_order_relaxed))
+		{
+			unsigned int const gen = generation.load(std::memory_order_acquire);
+			if (gen != seen)
+			{
+				seen = gen;
+				Work(self, gen);
+				idle = std::chrono::steady_clock::now();
+			}
+			else if (std::chrono::steady_clock::now() - idle < IDLE_SPIN_TIME)
+			{
+				Relax();
+			}
+			else
+			{
+				Nap();
+			}
+		}
+	}
+
+#ifdef WIN32
+	// worker thread entry point
+	static DWORD WINAPI WorkerProc(LPVOID param)
+	{
+		Worker(int(reinterpret_cast<INT_PTR>(param)));
+		return 0;
+	}
+#endif
+
+	// start worker threads
+	void Init(int const count, size_t const samples)
+	{
+		Done();
+
+		threads = Clamp(count, 0, MAX_THREADS);
+		capacity = samples;
+		quit.store(false);
+		for (int p = 0; p <= MAX_THREADS; ++p)
+			range[p].store(0);
+		for (int w = 0; w < threads; ++w)
+		{
+			int const self = w + 1;
+			participant_buffer[self] = static_cast<float *>(malloc(capacity * sizeof(float)));
+			participant_generation[self] = 0;
+#ifdef WIN32
+			worker[w] = CreateThread(NULL, 0, WorkerProc, reinterpret_cast<LPVOID>(INT_PTR(self)), 0, NULL);
+			SetThreadPriority(worker[w], THREAD_PRIORITY_TIME_CRITICAL);
+#else
+			worker[w] = new std::thread(Worker, self);
+#endif
+		}
+	}
+
+	// stop worker threads
+	void Done()
+	{
+		quit.store(true);
+		for (int w = 0; w < threads; ++w)
+		{
+#ifdef WIN32
+			WaitForSingleObject(worker[w], INFINITE);
+			CloseHandle(worker[w]);
+#else
+			worker[w]->join();
+			delete worker[w];
+#endif
+			worker[w] = NULL;
+			free(participant_buffer[w + 1]);
+			participant_buffer[w + 1] = NULL;
+		}
+		threads = 0;
+	}
+
+	// get the number of worker threads
+	int GetThreads()
+	{
+		return threads;
+	}
+
+	// run a job
+	void Run(int const tasks, Task task, void *context, float buffer[], size_t const count)
+	{
+		// run the tasks directly if there is nothing to share
+		if (threads == 0 || tasks < 2)
+		{
+			for (int t = 0; t < tasks; ++t)
+				task(t, buffer, context);
+			return;
+		}
+
+		assert(count <= capacity);
+		assert(tasks <= 0xFFFF);
+
+		// set up the job
+		unsigned int const gen = generation.load(std::memory_order_relaxed) + 1;
+		job_task = task;
+		job_context = context;
+		job_count = count;
+		completed.store(0, std::memory_order_relaxed);
+
+		// the calling thread adds directly to the output
+		participant_buffer[0] = buffer;
+		participant_generation[0] = gen;
+
+		// split the tasks evenly between participants
+		int const participants = threads + 1;
+		for (int p = 0; p < participants; ++p)
+		{
+			// (released so a worker stealing from it also sees the job)
+			range[p].store(PackRange(gen, tasks * (p + 1) / participants, tasks * p / participants), std::memory_order_release);
+		}
+
+		// publish the job
+		generation.store(gen, std::memory_order_release);
+
+		// take part in the job
+		Work(0, gen);
+
+		// wait for tasks still running on worker threads
+		while (completed.load(std::memory_order_acquire) < tasks)
+			Relax();
+
+		// combine worker results
+		for (int p = 1; p < participants; ++p)
+		{
+			if (participant_generation[p] != gen)
+				continue;
+			float const *source = participant_buffer[p];
+			for (size_t i = 0; i < count; ++i)
+				buffer[i] += source[i];
+		}
+	}
+
+	// most tasks in a check job
+	static int const CHECK_TASKS = 64;
+
+	// times each task of the current check job has run
+	static std::atomic<int> check_runs[CHECK_TASKS];
+
+	// check task: counts its runs and contributes one to the result
+	static void CheckTask(int const task, float buffer[], void *context)
+	{
+		check_runs[task].fetch_add(1, std::memory_order_relaxed);
+		buffer[0] += 1.0f;
+	}
+
+	// run back-to-back jobs and check that every task runs exactly once
+	int Check(int const count, int const jobs)
+	{
+		Init(count, 1);
+
+		int failed = 0;
+		for (int j = 0; j < jobs; ++j)
+		{
+			// vary the task count so the ranges shift from job to job
+			int const tasks = 2 + j % (CHECK_TASKS - 1);
+			for (int t = 0; t < CHECK_TASKS; ++t)
+				check_runs[t].store(0, std::memory_order_relaxed);
+
+			float result = 0.0f;
+			Run(tasks, CheckTask, NULL, &result, 1);
+
+			bool ok = result == float(tasks);
+			for (int t = 0; t < CHECK_TASKS; ++t)
+				ok &= check_runs[t].load(std::memory_order_relaxed) == (t < tasks ? 1 : 0);
+			if (!ok)
+				++failed;
+		}
+
+		Done();
+		return failed;
+	}
+}
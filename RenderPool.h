@@ -0,0 +1,42 @@
+#pragma once
+/*
+MINI VIRTUAL ANALOG SYNTHESIZER
+Copyright 2014 Kenneth D. Miller III
+
+Render Thread Pool
+*/
+
+// The render pool spreads independent tasks (voices or voice groups) across
+// a fixed set of worker threads.  Each worker owns a range of tasks and steals
+// from the other ranges when its own runs out; the calling thread takes part
+// as well.  Workers accumulate into private buffers that the calling thread
+// sums once every task is done.  Running a job takes no locks and allocates
+// no memory, so it is safe to use from the audio callback.
+
+namespace RenderPool
+{
+	// most worker threads
+	static int const MAX_THREADS = 32;
+
+	// task function: renders the task and adds the result to the buffer
+	typedef void(*Task)(int const task, float buffer[], void *context);
+
+	// start worker threads
+	// (samples is the largest buffer a job may use)
+	extern void Init(int const threads, size_t const samples);
+
+	// stop worker threads
+	extern void Done();
+
+	// get the number of worker threads
+	extern int GetThreads();
+
+	// run a job and add the combined results to the buffer
+	// (with no worker threads, runs the tasks in order on the calling thread)
+	extern void Run(int const tasks, Task task, void *context, float buffer[], size_t const count);
+
+	// run back-to-back jobs and check that every task runs exactly once
+	// (restarts the pool with the given worker threads and stops it afterward;
+	// returns the number of jobs that went wrong)
+	extern int Check(int const threads, int const jobs);
+}
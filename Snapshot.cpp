@@ -0,0 +1,116 @@
+/*
+MINI VIRTUAL ANALOG SYNTHESIZER
+Copyright 2014 Kenneth D. Miller III
+
+Patch Snapshots
+*/
+#include "StdAfx.h"
+
+#include <atomic>
+#ifndef WIN32
+#include <thread>
+#endif
+
+#include "Snapshot.h"
+
+// snapshots in rotation: one in use by the render thread, one being filled
+// by the interface thread, and one either published or retired
+static int const SNAPSHOTS = 3;
+static Snapshot *snapshot[SNAPSHOTS];
+
+// snapshot in use by the render thread
+Snapshot *render_snapshot;
+
+// snapshot being filled by the interface thread
+static Snapshot *staging;
+
+// published snapshot not yet picked up by the render thread
+static std::atomic<Snapshot *> published;
+
+// snapshot the render thread switched away from
+static std::atomic<Snapshot *> retired;
+
+// copy the edited configuration
+Snapshot::Snapshot()
+	: flt_config(::flt_config)
+	, flt_env_config(::flt_env_config)
+	, amp_config(::amp_config)
+	, amp_env_config(::amp_env_config)
+{
+	Capture();
+}
+
+void Snapshot::Capture()
+{
+	for (int o = 0; o < NUM_OSCILLATORS; ++o)
+		osc_config[o] = ::osc_config[o];
+	lfo_config = ::lfo_config;
+	flt_config = ::flt_config;
+	flt_env_config = ::flt_env_config;
+	amp_config = ::amp_config;
+	amp_env_config = ::amp_env_config;
+	use_antialias = ::use_antialias;
+	antialias_method = ::antialias_method;
+}
+
+// allocate snapshots holding the edited configuration
+void InitSnapshots()
+{
+	DoneSnapshots();
+	for (int i = 0; i < SNAPSHOTS; ++i)
+		snapshot[i] = new Snapshot;
+	render_snapshot = snapshot[0];
+	staging = snapshot[1];
+	published.store(NULL);
+	retired.store(snapshot[2]);
+}
+
+// free snapshots
+void DoneSnapshots()
+{
+	for (int i = 0; i < SNAPSHOTS; ++i)
+	{
+		delete snapshot[i];
+		snapshot[i] = NULL;
+	}
+	render_snapshot = NULL;
+	staging = NULL;
+}
+
+// publish the edited configuration to the render thread
+void PublishSnapshot()
+{
+	staging->Capture();
+
+	// replace the published snapshot
+	// (if the render thread never picked up the previous one, reuse it)
+	Snapshot *next = published.exchange(staging, std::memory_order_acq_rel);
+
+	// otherwise take the one the render thread retired
+	// (it may still be on its way if the render thread is switching right now)
+	while (!next)
+	{
+		next = retired.exchange(NULL, std::memory_order_acquire);
+		if (!next)
+		{
+#ifdef WIN32
+			SwitchToThread();
+#else
+			std::this_thread::yield();
+#endif
+		}
+	}
+	staging = next;
+}
+
+// switch to the latest published snapshot, if any
+void AcquireSnapshot()
+{
+	if (!published.load(std::memory_order_relaxed))
+		return;
+	Snapshot *next = published.exchange(NULL, std::memory_order_acq_rel);
+	if (!next)
+		return;
+	retired.store(render_snapshot, std::memory_order_release);
+	render_snapshot = next;
+}
@@ -0,0 +1,65 @@
+#pragma once
+/*
+MINI VIRTUAL ANALOG SYNTHESIZER
+Copyright 2014 Kenneth D. Miller III
+
+Patch Snapshots
+*/
+
+// The menus and the patch loader edit the global configurations (osc_config,
+// flt_config, and so on) on the user interface thread.  The render thread
+// never reads those directly.  Instead, the interface thread copies them into
+// a free snapshot and publishes it with a single atomic pointer exchange, and
+// the render thread picks up the latest snapshot at the start of each chunk.
+// The interface thread recycles the snapshot the render thread let go of, so
+// the render path takes no locks and frees nothing.
+
+#include "OscillatorNote.h"
+#include "OscillatorLFO.h"
+#include "Filter.h"
+#include "Amplifier.h"
+#include "Wave.h"
+
+// patch parameters seen by the render thread
+struct Snapshot
+{
+	NoteOscillatorConfig osc_config[NUM_OSCILLATORS];
+	LFOOscillatorConfig lfo_config;
+	FilterConfig flt_config;
+	EnvelopeConfig flt_env_config;
+	AmplifierConfig amp_config;
+	EnvelopeConfig amp_env_config;
+
+	// waveform antialiasing
+	bool use_antialias;
+	int antialias_method;
+
+	// get the antialiasing method in effect
+	// (ANTIALIAS_NONE if antialiasing is off)
+	int GetAntialias() const
+	{
+		return use_antialias ? antialias_method : ANTIALIAS_NONE;
+	}
+
+	// copy the edited configuration
+	Snapshot();
+	void Capture();
+};
+
+// snapshot in use by the render thread
+// (render thread only, or while nothing is rendering)
+extern Snapshot *render_snapshot;
+
+// allocate snapshots holding the edited configuration
+extern void InitSnapshots();
+
+// free snapshots
+extern void DoneSnapshots();
+
+// publish the edited configuration to the render thread
+// (user interface thread only)
+extern void PublishSnapshot();
+
+// switch to the latest published snapshot, if any
+// (render thread only)
+extern void AcquireSnapshot();
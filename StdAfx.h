@@ -1,14 +1,33 @@
 #pragma once
 
 // common includes
+#ifdef WIN32
 #include <windows.h>
-#include <stdio.h>
 #include <conio.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <float.h>
+#include <limits.h>
 #include <assert.h>
 
+// the headless renderer runs without the BASS sound library
+#ifndef SYNTH_HEADLESS
 #include "bass.h"
+#endif
+
+// compatibility with non-Microsoft compilers
+#ifndef _MSC_VER
+#define __forceinline inline __attribute__((always_inline))
+#define __assume(x) ((void)0)
+#define _aligned_malloc(size, alignment) aligned_alloc(alignment, size)
+#define _aligned_free(memory) free(memory)
+#if defined(__SSE__) && !defined(_M_IX86_FP)
+#define _M_IX86_FP 2
+#endif
+#endif
 
 #define ARRAY_SIZE(x) (sizeof(x)/sizeof(x[0]))
 
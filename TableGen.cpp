@@ -0,0 +1,308 @@
+/*
+MINI VIRTUAL ANALOG SYNTHESIZER
+Copyright 2014 Kenneth D. Miller III
+
+Lookup Table Generator
+*/
+#include "StdAfx.h"
+
+#include "TableGen.h"
+#include "WavePoly.h"
+#include "WaveHold.h"
+#include "MinBLEP.h"
+#include "Math.h"
+#include "Random.h"
+
+// kernel length in table entries
+#define MINBLEP_LENGTH (MINBLEP_TAPS * MINBLEP_OVERSAMPLE + 1)
+
+// sinc cutoff relative to the Nyquist frequency
+// (a little below Nyquist so the window's transition band aliases less)
+#define MINBLEP_CUTOFF 0.9
+
+// transform size for the cepstrum
+// (much longer than the kernel to keep time aliasing negligible)
+#define MINBLEP_FFT_SIZE 16384
+
+// pi in double precision
+static double const PI = 3.14159265358979323846;
+
+// generated tables
+static unsigned int gen_poly4[POLY_WORDS(POLY4_LENGTH)];
+static unsigned int gen_poly5[POLY_WORDS(POLY5_LENGTH)];
+static unsigned int gen_period93[POLY_WORDS(PERIOD93_LENGTH)];
+static unsigned int gen_poly9[POLY_WORDS(POLY9_LENGTH)];
+static unsigned int gen_poly17[POLY_WORDS(POLY17_LENGTH)];
+static unsigned int gen_pulsepoly5[POLY_WORDS(PULSE_POLY5_LENGTH)];
+static unsigned int gen_poly4poly5[POLY_WORDS(POLY4_POLY5_LENGTH)];
+static unsigned char gen_poly5_back[POLY5_LENGTH];
+static float gen_noise[ARRAY_SIZE(noise)];
+static float gen_minblep_step[MINBLEP_LENGTH];
+static float gen_minblep_ramp[MINBLEP_LENGTH];
+static float gen_minblep_delay;
+
+// set a sample in a packed table
+static void SetPolyBit(unsigned int bits[], int const index, int const value)
+{
+	bits[index >> 5] |= (unsigned int)(value) << (index & 31);
+}
+
+// repeat the start of a packed table after its end
+static void PadPoly(unsigned int bits[], int const length, int const words)
+{
+	for (int i = length; i < words * 32; ++i)
+		SetPolyBit(bits, i, GetPolyBit(bits, i - length));
+}
+
+// generate polynomial table
+// from Atari800 pokey.c
+static void InitPoly(unsigned int aOut[], int aWords, int aSize, int aTap, unsigned int aSeed, char aInvert)
+{
+	unsigned int x = aSeed;
+	unsigned int i = 0;
+	memset(aOut, 0, aWords * sizeof(aOut[0]));
+	do
+	{
+		SetPolyBit(aOut, i, (x & 1) ^ aInvert);
+		x = ((((x >> aTap) ^ x) & 1) << (aSize - 1)) | (x >> 1);
+		++i;
+	}
+	while (x != aSeed);
+	PadPoly(aOut, i, aWords);
+}
+
+// generate pulsepoly5 table
+static void InitPulsePoly5()
+{
+	int output = 0;
+	int index5 = 0;
+	memset(gen_pulsepoly5, 0, sizeof(gen_pulsepoly5));
+	for (int i = 0; i < PULSE_POLY5_LENGTH; ++i)
+	{
+		if (GetPolyBit(gen_poly5, index5))
+			output = !output;
+		SetPolyBit(gen_pulsepoly5, i, output);
+		if (++index5 == POLY5_LENGTH)
+			index5 = 0;
+	}
+	PadPoly(gen_pulsepoly5, PULSE_POLY5_LENGTH, ARRAY_SIZE(gen_pulsepoly5));
+}
+
+// generate poly4poly5 table
+static void InitPoly4Poly5()
+{
+	int output = 0;
+	int index5 = 0;
+	int index4 = 0;
+	memset(gen_poly4poly5, 0, sizeof(gen_poly4poly5));
+	for (int i = 0; i < POLY4_POLY5_LENGTH; ++i)
+	{
+		if (++index4 == POLY4_LENGTH)
+			index4 = 0;
+		if (GetPolyBit(gen_poly5, index5))
+			output = GetPolyBit(gen_poly4, index4);
+		SetPolyBit(gen_poly4poly5, i, output);
+		if (++index5 == POLY5_LENGTH)
+			index5 = 0;
+	}
+	PadPoly(gen_poly4poly5, POLY4_POLY5_LENGTH, ARRAY_SIZE(gen_poly4poly5));
+}
+
+// find the last poly5 clock at or before each poly5 index
+static void InitPoly5Back()
+{
+	for (int i = 0; i < POLY5_LENGTH; ++i)
+	{
+		int back = 0;
+		while (!GetPolyBit(gen_poly5, (i - back + POLY5_LENGTH) % POLY5_LENGTH))
+			++back;
+		gen_poly5_back[i] = (unsigned char)(back);
+	}
+}
+
+// generate polynomial noise tables
+static void InitPoly()
+{
+	InitPoly(gen_poly4, ARRAY_SIZE(gen_poly4), 4, 1, 0xF, 0);
+	InitPoly(gen_poly5, ARRAY_SIZE(gen_poly5), 5, 2, 0x1F, 1);
+	InitPoly(gen_period93, ARRAY_SIZE(gen_period93), 15, 6, 0x7FFF, 0);
+	InitPoly(gen_poly9, ARRAY_SIZE(gen_poly9), 9, 4, 0x1FF, 0);
+	InitPoly(gen_poly17, ARRAY_SIZE(gen_poly17), 17, 5, 0x1FFFF, 0);
+	InitPulsePoly5();
+	InitPoly4Poly5();
+	InitPoly5Back();
+}
+
+// generate noise wavetable
+// (from the random number generator's initial seed)
+static void InitNoise()
+{
+	for (int i = 0; i < ARRAY_SIZE(gen_noise); ++i)
+	{
+		gen_noise[i] = Random::Float() * 2.0f - 1.0f;
+	}
+}
+
+// generate minBLEP tables
+static void InitMinBLEP()
+{
+	double *re = static_cast<double *>(malloc(MINBLEP_FFT_SIZE * sizeof(double)));
+	double *im = static_cast<double *>(malloc(MINBLEP_FFT_SIZE * sizeof(double)));
+
+	// blackman-windowed sinc spanning MINBLEP_TAPS samples
+	for (int i = 0; i < MINBLEP_FFT_SIZE; ++i)
+	{
+		re[i] = 0.0;
+		im[i] = 0.0;
+	}
+	for (int i = 0; i < MINBLEP_LENGTH; ++i)
+	{
+		double const x = double(i - MINBLEP_LENGTH / 2) / MINBLEP_OVERSAMPLE;
+		double const sinc = x ? sin(PI * MINBLEP_CUTOFF * x) / (PI * x) : MINBLEP_CUTOFF;
+		double const r = double(i) / (MINBLEP_LENGTH - 1);
+		double const window = 0.42 - 0.5 * cos(2 * PI * r) + 0.08 * cos(4 * PI * r);
+		re[i] = sinc * window;
+	}
+
+	// real cepstrum
+	FourierTransform(re, im, MINBLEP_FFT_SIZE, false);
+	for (int i = 0; i < MINBLEP_FFT_SIZE; ++i)
+	{
+		re[i] = log(Max(sqrt(re[i] * re[i] + im[i] * im[i]), 1e-30));
+		im[i] = 0.0;
+	}
+	FourierTransform(re, im, MINBLEP_FFT_SIZE, true);
+
+	// fold the anticausal part onto the causal part
+	for (int i = 1; i < MINBLEP_FFT_SIZE / 2; ++i)
+		re[i] *= 2.0;
+	for (int i = MINBLEP_FFT_SIZE / 2 + 1; i < MINBLEP_FFT_SIZE; ++i)
+		re[i] = 0.0;
+	for (int i = 0; i < MINBLEP_FFT_SIZE; ++i)
+		im[i] = 0.0;
+
+	// minimum-phase impulse from the folded cepstrum
+	FourierTransform(re, im, MINBLEP_FFT_SIZE, false);
+	for (int i = 0; i < MINBLEP_FFT_SIZE; ++i)
+	{
+		double const magnitude = exp(re[i]);
+		re[i] = magnitude * cos(im[i]);
+		im[i] = magnitude * sin(im[i]);
+	}
+	FourierTransform(re, im, MINBLEP_FFT_SIZE, true);
+
+	// integrate the impulse into the step, normalized to end at 1
+	double sum = 0.0;
+	for (int i = 0; i < MINBLEP_LENGTH; ++i)
+	{
+		sum += re[i];
+		im[i] = sum;
+	}
+	for (int i = 0; i < MINBLEP_LENGTH; ++i)
+		im[i] /= sum;
+
+	// integrate the step into the ramp and measure the delay
+	double ramp = 0.0;
+	re[0] = 0.0;
+	for (int i = 1; i < MINBLEP_LENGTH; ++i)
+	{
+		ramp += 0.5 * (im[i - 1] + im[i]) / MINBLEP_OVERSAMPLE;
+		re[i] = ramp;
+	}
+	double const delay = MINBLEP_TAPS - ramp;
+
+	// residuals relative to the ideal step and the delayed ideal ramp
+	for (int i = 0; i < MINBLEP_LENGTH; ++i)
+	{
+		double const t = double(i) / MINBLEP_OVERSAMPLE;
+		gen_minblep_step[i] = float(im[i] - 1.0);
+		gen_minblep_ramp[i] = float(re[i] - t + delay);
+	}
+	gen_minblep_step[MINBLEP_LENGTH - 1] = 0.0f;
+	gen_minblep_ramp[MINBLEP_LENGTH - 1] = 0.0f;
+	gen_minblep_delay = float(delay);
+
+	free(re);
+	free(im);
+}
+
+// write an array of words
+static void WriteWords(FILE *file, char const *name, char const *size, unsigned int const data[], int const count)
+{
+	fprintf(file, "\nunsigned int const %s[%s] =\n{", name, size);
+	for (int i = 0; i < count; ++i)
+		fprintf(file, "%s0x%08X,", (i & 7) ? " " : "\n\t", data[i]);
+	fprintf(file, "\n};\n");
+}
+
+// write an array of bytes
+static void WriteBytes(FILE *file, char const *name, char const *size, unsigned char const data[], int const count)
+{
+	fprintf(file, "\nunsigned char const %s[%s] =\n{", name, size);
+	for (int i = 0; i < count; ++i)
+		fprintf(file, "%s%d,", (i & 15) ? " " : "\n\t", data[i]);
+	fprintf(file, "\n};\n");
+}
+
+// format a float so it reads back exactly
+static char const *FormatFloat(char buffer[], float const value)
+{
+	sprintf(buffer, "%.9g", value);
+	if (!strpbrk(buffer, ".e"))
+		strcat(buffer, ".0");
+	strcat(buffer, "f");
+	return buffer;
+}
+
+// write an array of floats
+static void WriteFloats(FILE *file, char const *name, char const *size, float const data[], int const count)
+{
+	char buffer[32];
+	fprintf(file, "\nfloat const %s[%s] =\n{", name, size);
+	for (int i = 0; i < count; ++i)
+		fprintf(file, "%s%s,", (i & 7) ? " " : "\n\t", FormatFloat(buffer, data[i]));
+	fprintf(file, "\n};\n");
+}
+
+// write the lookup tables as a C++ source file
+bool WriteTables(char const *filename)
+{
+	InitPoly();
+	InitNoise();
+	InitMinBLEP();
+
+	FILE *file = fopen(filename, "w");
+	if (!file)
+		return false;
+
+	fprintf(file,
+		"/*\n"
+		"MINI VIRTUAL ANALOG SYNTHESIZER\n"
+		"Copyright 2014 Kenneth D. Miller III\n"
+		"\n"
+		"Precomputed Lookup Tables\n"
+		"(generated by \"offline -tables\"; do not edit)\n"
+		"*/\n"
+		"#include \"StdAfx.h\"\n"
+		"\n"
+		"#include \"WavePoly.h\"\n"
+		"#include \"WaveHold.h\"\n"
+		"#include \"MinBLEP.h\"\n");
+
+	WriteWords(file, "poly4", "POLY_WORDS(POLY4_LENGTH)", gen_poly4, ARRAY_SIZE(gen_poly4));
+	WriteWords(file, "poly5", "POLY_WORDS(POLY5_LENGTH)", gen_poly5, ARRAY_SIZE(gen_poly5));
+	WriteWords(file, "period93", "POLY_WORDS(PERIOD93_LENGTH)", gen_period93, ARRAY_SIZE(gen_period93));
+	WriteWords(file, "poly9", "POLY_WORDS(POLY9_LENGTH)", gen_poly9, ARRAY_SIZE(gen_poly9));
+	WriteWords(file, "poly17", "POLY_WORDS(POLY17_LENGTH)", gen_poly17, ARRAY_SIZE(gen_poly17));
+	WriteWords(file, "pulsepoly5", "POLY_WORDS(PULSE_POLY5_LENGTH)", gen_pulsepoly5, ARRAY_SIZE(gen_pulsepoly5));
+	WriteWords(file, "poly4poly5", "POLY_WORDS(POLY4_POLY5_LENGTH)", gen_poly4poly5, ARRAY_SIZE(gen_poly4poly5));
+	WriteBytes(file, "poly5_back", "POLY5_LENGTH", gen_poly5_back, ARRAY_SIZE(gen_poly5_back));
+	WriteFloats(file, "noise", "NOISE_LENGTH", gen_noise, ARRAY_SIZE(gen_noise));
+	WriteFloats(file, "minblep_step", "MINBLEP_TAPS * MINBLEP_OVERSAMPLE + 1", gen_minblep_step, ARRAY_SIZE(gen_minblep_step));
+	WriteFloats(file, "minblep_ramp", "MINBLEP_TAPS * MINBLEP_OVERSAMPLE + 1", gen_minblep_ramp, ARRAY_SIZE(gen_minblep_ramp));
+
+	char buffer[32];
+	fprintf(file, "\nfloat const minblep_delay = %s;\n", FormatFloat(buffer, gen_minblep_delay));
+
+	return fclose(file) == 0;
+}
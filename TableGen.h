@@ -0,0 +1,16 @@
+#pragma once
+/*
+MINI VIRTUAL ANALOG SYNTHESIZER
+Copyright 2014 Kenneth D. Miller III
+
+Lookup Table Generator
+*/
+
+// The poly, noise, and minBLEP tables never change, so they are generated
+// ahead of time into WaveData.cpp and compiled into the program as read-only
+// data instead of being built at startup.  Regenerate that file with
+// "offline -tables WaveData.cpp" after changing anything that feeds them.
+
+// write the lookup tables as a C++ source file
+// (returns false if the file could not be written)
+extern bool WriteTables(char const *filename);
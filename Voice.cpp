@@ -1,16 +1,163 @@
 #include "StdAfx.h"
 
 #include "Voice.h"
+#include "Math.h"
 #include "OscillatorNote.h"
 #include "Filter.h"
 #include "Amplifier.h"
 #include "Control.h"
+#include "Snapshot.h"
+#include "Random.h"
+
+#include <new>
+
+// number of voices
+int voice_count;
 
 // current note assignemnts
 // (via keyboard or midi input)
-unsigned char voice_note[VOICES];
-unsigned char voice_vel[VOICES];
-unsigned char note_voice[NOTES];
+unsigned char *voice_note;
+unsigned char *voice_vel;
+
+// samples each voice has stayed below the silence threshold while falling
+unsigned int *voice_quiet;
+
+// voice assigned to each note
+// (-1 if none; cleared when the voice is stolen or falls silent)
+static short note_voice[NOTES];
+
+// Voice allocation
+// Silent voices wait on a free list.  Sounding voices sit in a binary heap
+// ordered by steal priority: released voices first, then the quietest, then
+// the oldest.  Note on takes a free voice or the top of the heap, so the cost
+// does not grow with polyphony.  Amplitudes are refreshed by UpdateVoices
+// after each rendered chunk, which also returns finished voices to the free
+// list.
+
+// steal priority of a sounding voice
+struct VoiceRank
+{
+	float amplitude;
+	unsigned int serial;
+	bool released;
+};
+static VoiceRank *voice_rank;
+
+// free voice stack
+static int *free_voice;
+static int free_count;
+
+// steal heap and the position of each voice in it
+// (-1 if the voice is not in the heap)
+static int *steal_heap;
+static int *steal_slot;
+static int steal_count;
+
+// note on counter for voice age
+static unsigned int voice_serial;
+
+// voice pool
+// (a single allocation holding every per-voice array, each one starting on
+// its own cache line so voices never share lines across arrays)
+static size_t const VOICE_POOL_ALIGN = 64;
+static void *voice_pool;
+
+// get the pool space needed for an array
+template <typename T> static size_t VoiceArraySize(int const count)
+{
+	return (count * sizeof(T) + VOICE_POOL_ALIGN - 1) & ~(VOICE_POOL_ALIGN - 1);
+}
+
+// carve a constructed array out of the voice pool
+template <typename T> static T *CarveVoiceArray(char *&pool, int const count)
+{
+	T *array = reinterpret_cast<T *>(pool);
+	for (int i = 0; i < count; ++i)
+		new (&array[i]) T();
+	pool += VoiceArraySize<T>(count);
+	return array;
+}
+
+// allocate the voice pool
+bool InitVoices(int count)
+{
+	DoneVoices();
+
+	count = Clamp(count, 1, MAX_VOICES);
+
+	// allocate space for all the per-voice arrays
+	size_t const size =
+		VoiceArraySize<unsigned char>(count) +
+		VoiceArraySize<unsigned char>(count) +
+		VoiceArraySize<unsigned int>(count) +
+		VoiceArraySize<OscillatorState[NUM_OSCILLATORS]>(count) +
+		VoiceArraySize<FilterState>(count) +
+		VoiceArraySize<EnvelopeState>(count) +
+		VoiceArraySize<EnvelopeState>(count) +
+		VoiceArraySize<VoiceRank>(count) +
+		VoiceArraySize<int>(count) +
+		VoiceArraySize<int>(count) +
+		VoiceArraySize<int>(count);
+	voice_pool = _aligned_malloc(size, VOICE_POOL_ALIGN);
+	if (!voice_pool)
+		return false;
+	memset(voice_pool, 0, size);
+
+	// set up the per-voice arrays
+	char *pool = static_cast<char *>(voice_pool);
+	voice_note = CarveVoiceArray<unsigned char>(pool, count);
+	voice_vel = CarveVoiceArray<unsigned char>(pool, count);
+	voice_quiet = CarveVoiceArray<unsigned int>(pool, count);
+	osc_state = reinterpret_cast<OscillatorState (*)[NUM_OSCILLATORS]>(CarveVoiceArray<OscillatorState>(pool, count * NUM_OSCILLATORS));
+	flt_state = CarveVoiceArray<FilterState>(pool, count);
+	flt_env_state = CarveVoiceArray<EnvelopeState>(pool, count);
+	amp_env_state = CarveVoiceArray<EnvelopeState>(pool, count);
+	voice_rank = CarveVoiceArray<VoiceRank>(pool, count);
+	free_voice = CarveVoiceArray<int>(pool, count);
+	steal_heap = CarveVoiceArray<int>(pool, count);
+	steal_slot = CarveVoiceArray<int>(pool, count);
+	assert(pool == static_cast<char *>(voice_pool) + size);
+
+	// forget previous note assignments
+	memset(note_voice, -1, sizeof(note_voice));
+	voice_most_recent = 0;
+
+	// every voice starts out free
+	// (handed out in index order)
+	for (int v = 0; v < count; ++v)
+	{
+		free_voice[v] = count - 1 - v;
+		steal_slot[v] = -1;
+	}
+	free_count = count;
+	steal_count = 0;
+	voice_serial = 0;
+
+	voice_count = count;
+	return true;
+}
+
+// free the voice pool
+void DoneVoices()
+{
+	// the voice state types hold no resources, so there is nothing to destroy
+	_aligned_free(voice_pool);
+	voice_pool = NULL;
+	voice_note = NULL;
+	voice_vel = NULL;
+	voice_quiet = NULL;
+	osc_state = NULL;
+	flt_state = NULL;
+	flt_env_state = NULL;
+	amp_env_state = NULL;
+	voice_rank = NULL;
+	free_voice = NULL;
+	steal_heap = NULL;
+	steal_slot = NULL;
+	free_count = 0;
+	steal_count = 0;
+	voice_count = 0;
+}
 
 // most recent voice triggered
 int voice_most_recent;
@@ -19,49 +166,144 @@ int voice_most_recent;
 // (via keyboard or midi input)
 int note_most_recent;
 
-// choose a voice
-int ChooseVoice(int note)
+// true if voice a should be stolen before voice b
+static bool StealFirst(int const a, int const b)
 {
-	int voice = -1;
+	VoiceRank const &rank_a = voice_rank[a];
+	VoiceRank const &rank_b = voice_rank[b];
+	if (rank_a.released != rank_b.released)
+		return rank_a.released;
+	if (rank_a.amplitude != rank_b.amplitude)
+		return rank_a.amplitude < rank_b.amplitude;
+	return int(rank_a.serial - rank_b.serial) < 0;
+}
 
-	// quietest voice
-	int quietest_voice = -1;
-	float quietest_amplitude = FLT_MAX;
+// put a voice into a steal heap slot
+static void SetSlot(int const slot, int const voice)
+{
+	steal_heap[slot] = voice;
+	steal_slot[voice] = slot;
+}
 
-	// find a voice to use
-	for (int v = 0; v < VOICES; ++v)
+// move the voice in a heap slot toward the top
+static void SiftUp(int slot)
+{
+	int const voice = steal_heap[slot];
+	while (slot > 0)
 	{
-		// if retriggering the voice or the voice is currently off...
-		if (voice_note[v] == note || amp_env_state[v].state == EnvelopeState::OFF)
-		{
-			// use this voice
-			voice = v;
+		int const parent = (slot - 1) / 2;
+		if (!StealFirst(voice, steal_heap[parent]))
 			break;
-		}
+		SetSlot(slot, steal_heap[parent]);
+		slot = parent;
+	}
+	SetSlot(slot, voice);
+}
 
-		// if the voice is quieter than the current quietest...
-		if (amp_env_state[v].amplitude < quietest_amplitude)
-		{
-			// use that
-			quietest_voice = v;
-			quietest_amplitude = amp_env_state[v].amplitude;
-		}
+// move the voice in a heap slot toward the bottom
+static void SiftDown(int slot)
+{
+	int const voice = steal_heap[slot];
+	for (;;)
+	{
+		int child = slot * 2 + 1;
+		if (child >= steal_count)
+			break;
+		if (child + 1 < steal_count && StealFirst(steal_heap[child + 1], steal_heap[child]))
+			++child;
+		if (!StealFirst(steal_heap[child], voice))
+			break;
+		SetSlot(slot, steal_heap[child]);
+		slot = child;
 	}
+	SetSlot(slot, voice);
+}
 
-	// use the quietest voice if not already assigned a voice
-	if (voice < 0)
+// take a voice out of the steal heap
+static void RemoveSteal(int const voice)
+{
+	int const slot = steal_slot[voice];
+	steal_slot[voice] = -1;
+	int const last = steal_heap[--steal_count];
+	if (last == voice)
+		return;
+	SetSlot(slot, last);
+	SiftUp(slot);
+	SiftDown(steal_slot[last]);
+}
+
+// forget the note assigned to a voice
+static void UnassignNote(int const voice)
+{
+	if (note_voice[voice_note[voice]] == voice)
+		note_voice[voice_note[voice]] = -1;
+}
+
+// choose a voice
+static int ChooseVoice(int note)
+{
+	// retrigger the voice already playing the note
+	int voice = note_voice[note];
+	if (voice >= 0)
+		return voice;
+
+	// use a free voice if there is one
+	if (free_count > 0)
+		return free_voice[--free_count];
+
+	// otherwise steal the voice with the highest priority
+	if (steal_count > 0)
 	{
-		voice = quietest_voice;
+		voice = steal_heap[0];
+		RemoveSteal(voice);
+		UnassignNote(voice);
+		return voice;
 	}
 
-	return voice;
+	return -1;
+}
+
+// retire a voice
+void RetireVoice(int voice)
+{
+	amp_env_state[voice].Stop();
+	flt_env_state[voice].Stop();
+}
+
+// update voice steal priorities
+void UpdateVoices()
+{
+	// return finished voices to the free list and refresh the rest
+	int remain = 0;
+	for (int i = 0; i < steal_count; ++i)
+	{
+		int const v = steal_heap[i];
+		EnvelopeState const &env = amp_env_state[v];
+		if (env.state == EnvelopeState::OFF)
+		{
+			steal_slot[v] = -1;
+			UnassignNote(v);
+			free_voice[free_count++] = v;
+		}
+		else
+		{
+			voice_rank[v].amplitude = env.amplitude;
+			voice_rank[v].released = env.state == EnvelopeState::RELEASE;
+			SetSlot(remain++, v);
+		}
+	}
+	steal_count = remain;
+
+	// rebuild the heap
+	for (int slot = steal_count / 2 - 1; slot >= 0; --slot)
+		SiftDown(slot);
 }
 
 // note frequency
 float NoteFrequency(int note, float follow)
 {
 	float const base = (note - 60) / 12.0f + Control::pitch_offset;
-	return powf(2, follow * base) * middle_c_frequency;
+	return FastExp2(follow * base) * middle_c_frequency;
 }
 
 // note on
@@ -77,16 +319,20 @@ int NoteOn(int note, int velocity)
 	note_most_recent = note;
 
 	// set voice note
-	voice_note[voice] = unsigned char(note);
-	note_voice[note] = unsigned char(voice);
+	voice_note[voice] = (unsigned char)(note);
+	note_voice[note] = short(voice);
 
 	// set voice velocity
-	voice_vel[voice] = unsigned char(velocity);
+	voice_vel[voice] = (unsigned char)(velocity);
+
+	// the voice has not been quiet yet
+	voice_quiet[voice] = 0;
 
 	// start the oscillator
-	// (assume restart on key)
+	// (assume restart on key; noise is seeded from the voice and the note-on
+	// count so renders are reproducible)
 	for (int o = 0; o < NUM_OSCILLATORS; ++o)
-		osc_state[voice][o].Start();
+		osc_state[voice][o].Start(Random::Hash(voice * NUM_OSCILLATORS + o, voice_serial));
 
 	// start the filter
 	flt_state[voice].Reset();
@@ -100,10 +346,26 @@ int NoteOn(int note, int velocity)
 	}
 
 	// gate the volume envelope
-	amp_env_state[voice].Gate(amp_env_config, true);
+	amp_env_state[voice].Gate(render_snapshot->amp_env_config, true);
 
 	// gate the filter envelope
-	flt_env_state[voice].Gate(flt_env_config, true);
+	flt_env_state[voice].Gate(render_snapshot->flt_env_config, true);
+
+	// rank the voice as the newest
+	VoiceRank &rank = voice_rank[voice];
+	rank.amplitude = amp_env_state[voice].amplitude;
+	rank.serial = voice_serial++;
+	rank.released = false;
+	if (steal_slot[voice] < 0)
+	{
+		SetSlot(steal_count++, voice);
+		SiftUp(steal_slot[voice]);
+	}
+	else
+	{
+		SiftDown(steal_slot[voice]);
+		SiftUp(steal_slot[voice]);
+	}
 
 	return voice;
 }
@@ -119,10 +381,17 @@ int NoteOff(int note, int velocity)
 	// TO DO: use note-off velocity
 
 	// gate the volume envelope
-	amp_env_state[voice].Gate(amp_env_config, false);
+	amp_env_state[voice].Gate(render_snapshot->amp_env_config, false);
 
 	// gate the filter envelope
-	flt_env_state[voice].Gate(flt_env_config, false);
+	flt_env_state[voice].Gate(render_snapshot->flt_env_config, false);
+
+	// released voices are stolen first
+	if (steal_slot[voice] >= 0 && !voice_rank[voice].released)
+	{
+		voice_rank[voice].released = true;
+		SiftUp(steal_slot[voice]);
+	}
 
 	return voice;
 }
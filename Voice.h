@@ -15,13 +15,23 @@ const float middle_c_frequency = 261.6255653005986346778499935233f;
 // (11 octaves + 1)
 #define NOTES 133
 
+// default number of voices
+#define DEFAULT_VOICES 16
+
+// most voices supported
+#define MAX_VOICES 256
+
 // number of voices
-#define VOICES 16
+extern int voice_count;
 
 // current note assignemnts
 // (via keyboard or midi input)
-extern unsigned char voice_note[VOICES];
-extern unsigned char voice_vel[VOICES];
+extern unsigned char *voice_note;
+extern unsigned char *voice_vel;
+
+// samples each voice has stayed below the silence threshold while falling
+// (reset on note on; see SILENCE_WINDOW)
+extern unsigned int *voice_quiet;
 
 // most recent voice triggered
 extern int voice_most_recent;
@@ -30,6 +40,13 @@ extern int voice_most_recent;
 // (via keyboard or midi input)
 extern int note_most_recent;
 
+// allocate the voice pool
+// (call while nothing is rendering; returns false if out of memory)
+extern bool InitVoices(int count);
+
+// free the voice pool
+extern void DoneVoices();
+
 // note frequency
 extern float NoteFrequency(int note, float follow);
 
@@ -40,3 +57,11 @@ extern int NoteOn(int note, int velocity = 64);
 // note off
 // (returns voice index)
 extern int NoteOff(int note, int velocity = 64);
+
+// retire a voice immediately
+// (safe to call from render tasks; UpdateVoices returns it to the free list)
+extern void RetireVoice(int voice);
+
+// update voice steal priorities and free voices that have gone silent
+// (call from the render thread after each rendered chunk)
+extern void UpdateVoices();
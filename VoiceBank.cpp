@@ -0,0 +1,972 @@
+/*
+MINI VIRTUAL ANALOG SYNTHESIZER
+Copyright 2014 Kenneth D. Miller III
+
+Voice Bank
+*/
+#include "StdAfx.h"
+
+#include "VoiceBank.h"
+#include "Math.h"
+#include "Voice.h"
+#include "Render.h"
+#include "OscillatorNote.h"
+#include "Filter.h"
+#include "Amplifier.h"
+#include "Snapshot.h"
+#include "PolyBLEP.h"
+
+#if VOICE_BANK
+
+#if VOICE_BANK_LANES == 8
+#include <immintrin.h>
+#else
+#include <emmintrin.h>
+#endif
+
+// lane vector operations
+// (arguments are limited to three vectors for the 32-bit calling conventions)
+#if VOICE_BANK_LANES == 8
+
+typedef __m256 Lanes;
+typedef __m256i LanesInt;
+
+static __forceinline Lanes Set(float const x) { return _mm256_set1_ps(x); }
+static __forceinline Lanes Load(float const *p) { return _mm256_loadu_ps(p); }
+static __forceinline void Store(float *p, Lanes const a) { _mm256_storeu_ps(p, a); }
+static __forceinline LanesInt LoadInt(int const *p) { return _mm256_loadu_si256((LanesInt const *)p); }
+static __forceinline void StoreInt(int *p, LanesInt const a) { _mm256_storeu_si256((LanesInt *)p, a); }
+static __forceinline Lanes Add(Lanes const a, Lanes const b) { return _mm256_add_ps(a, b); }
+static __forceinline Lanes Sub(Lanes const a, Lanes const b) { return _mm256_sub_ps(a, b); }
+static __forceinline Lanes Mul(Lanes const a, Lanes const b) { return _mm256_mul_ps(a, b); }
+static __forceinline Lanes Div(Lanes const a, Lanes const b) { return _mm256_div_ps(a, b); }
+static __forceinline Lanes Minimum(Lanes const a, Lanes const b) { return _mm256_min_ps(a, b); }
+static __forceinline Lanes Maximum(Lanes const a, Lanes const b) { return _mm256_max_ps(a, b); }
+static __forceinline Lanes And(Lanes const a, Lanes const b) { return _mm256_and_ps(a, b); }
+static __forceinline Lanes AndNot(Lanes const a, Lanes const b) { return _mm256_andnot_ps(a, b); }
+static __forceinline Lanes Or(Lanes const a, Lanes const b) { return _mm256_or_ps(a, b); }
+static __forceinline Lanes Less(Lanes const a, Lanes const b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+static __forceinline Lanes LessEqual(Lanes const a, Lanes const b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+static __forceinline Lanes GreaterEqual(Lanes const a, Lanes const b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+static __forceinline Lanes Select(Lanes const mask, Lanes const a, Lanes const b) { return _mm256_blendv_ps(b, a, mask); }
+static __forceinline int MoveMask(Lanes const a) { return _mm256_movemask_ps(a); }
+static __forceinline LanesInt FloorInt(Lanes const a) { return _mm256_srai_epi32(_mm256_cvtps_epi32(_mm256_sub_ps(_mm256_add_ps(a, a), _mm256_set1_ps(0.5f))), 1); }
+static __forceinline Lanes ToFloat(LanesInt const a) { return _mm256_cvtepi32_ps(a); }
+static __forceinline LanesInt AddInt(LanesInt const a, LanesInt const b) { return _mm256_add_epi32(a, b); }
+
+#else
+
+typedef __m128 Lanes;
+typedef __m128i LanesInt;
+
+static __forceinline Lanes Set(float const x) { return _mm_set1_ps(x); }
+static __forceinline Lanes Load(float const *p) { return _mm_loadu_ps(p); }
+static __forceinline void Store(float *p, Lanes const a) { _mm_storeu_ps(p, a); }
+static __forceinline LanesInt LoadInt(int const *p) { return _mm_loadu_si128((LanesInt const *)p); }
+static __forceinline void StoreInt(int *p, LanesInt const a) { _mm_storeu_si128((LanesInt *)p, a); }
+static __forceinline Lanes Add(Lanes const a, Lanes const b) { return _mm_add_ps(a, b); }
+static __forceinline Lanes Sub(Lanes const a, Lanes const b) { return _mm_sub_ps(a, b); }
+static __forceinline Lanes Mul(Lanes const a, Lanes const b) { return _mm_mul_ps(a, b); }
+static __forceinline Lanes Div(Lanes const a, Lanes const b) { return _mm_div_ps(a, b); }
+static __forceinline Lanes Minimum(Lanes const a, Lanes const b) { return _mm_min_ps(a, b); }
+static __forceinline Lanes Maximum(Lanes const a, Lanes const b) { return _mm_max_ps(a, b); }
+static __forceinline Lanes And(Lanes const a, Lanes const b) { return _mm_and_ps(a, b); }
+static __forceinline Lanes AndNot(Lanes const a, Lanes const b) { return _mm_andnot_ps(a, b); }
+static __forceinline Lanes Or(Lanes const a, Lanes const b) { return _mm_or_ps(a, b); }
+static __forceinline Lanes Less(Lanes const a, Lanes const b) { return _mm_cmplt_ps(a, b); }
+static __forceinline Lanes LessEqual(Lanes const a, Lanes const b) { return _mm_cmple_ps(a, b); }
+static __forceinline Lanes GreaterEqual(Lanes const a, Lanes const b) { return _mm_cmpge_ps(a, b); }
+static __forceinline Lanes Select(Lanes const mask, Lanes const a, Lanes const b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+static __forceinline int MoveMask(Lanes const a) { return _mm_movemask_ps(a); }
+static __forceinline LanesInt FloorInt(Lanes const a) { return _mm_srai_epi32(_mm_cvtps_epi32(_mm_sub_ps(_mm_add_ps(a, a), _mm_set1_ps(0.5f))), 1); }
+static __forceinline Lanes ToFloat(LanesInt const a) { return _mm_cvtepi32_ps(a); }
+static __forceinline LanesInt AddInt(LanesInt const a, LanesInt const b) { return _mm_add_epi32(a, b); }
+
+#endif
+
+// absolute value
+static __forceinline Lanes Abs(Lanes const a)
+{
+	return AndNot(Set(-0.0f), a);
+}
+
+// convert a comparison mask to 0 or 1
+static __forceinline Lanes MaskToOne(Lanes const mask)
+{
+	return And(mask, Set(1.0f));
+}
+
+// lane version of FastTanh
+static __forceinline Lanes FastTanh(Lanes x)
+{
+	x = Minimum(Maximum(x, Set(-3.0f)), Set(3.0f));
+	Lanes const xx = Mul(x, x);
+	return Div(Mul(x, Add(Set(27.0f), xx)), Add(Set(27.0f), Mul(Mul(Set(9.0f), x), x)));
+}
+
+// lane version of PolyBLEP for a value step of 2 units
+static __forceinline Lanes PolyBLEP(Lanes t, Lanes const w)
+{
+	Lanes const inside = Less(Abs(t), w);
+	t = Div(t, w);
+	Lanes tt1 = Add(Mul(t, t), Set(1.0f));
+	tt1 = Select(GreaterEqual(t, Set(0.0f)), Sub(Set(0.0f), tt1), tt1);
+	return And(inside, Add(Add(tt1, t), t));
+}
+
+// lane version of IntegratedPolyBLEP for a slope step of 8 units
+static __forceinline Lanes IntegratedPolyBLEP(Lanes const t, Lanes const w)
+{
+	Lanes at = Abs(t);
+	Lanes const inside = Less(at, w);
+	at = Div(at, w);
+	Lanes const t2 = Mul(at, at);
+	Lanes const t4 = Mul(t2, t2);
+	Lanes const poly = Sub(Add(Sub(Set(0.375f), at), Mul(Set(0.75f), t2)), Mul(Set(0.125f), t4));
+	return And(inside, Mul(Mul(poly, w), Set(4.0f)));
+}
+
+// sawtooth wave
+// (lane version of OscillatorSawtooth without sync)
+static __forceinline Lanes Sawtooth(Lanes const phase, Lanes const delta, bool const antialias)
+{
+	Lanes value = Sub(Sub(Set(1.0f), phase), phase);
+	if (antialias)
+	{
+		Lanes const w = Minimum(Mul(delta, Set(POLYBLEP_WIDTH)), Set(0.5f));
+		Lanes const up_nearest = MaskToOne(GreaterEqual(phase, Set(0.5f)));
+		value = Add(value, PolyBLEP(Sub(phase, up_nearest), w));
+	}
+	return value;
+}
+
+// pulse wave
+// (lane version of OscillatorPulse without sync)
+static __forceinline Lanes Pulse(Lanes const phase, Lanes const delta, float const waveparam, bool const antialias)
+{
+	if (waveparam <= 0.0f)
+		return Set(-1.0f);
+	if (waveparam >= 1.0f)
+		return Set(1.0f);
+	Lanes const width = Set(waveparam);
+	Lanes value = Select(Less(phase, width), Set(1.0f), Set(-1.0f));
+	if (antialias)
+	{
+		Lanes const w = Minimum(Mul(delta, Set(POLYBLEP_WIDTH)), Set(0.5f));
+		Lanes const half = Set(0.5f);
+		Lanes const up_nearest = MaskToOne(GreaterEqual(Sub(phase, half), Set(0.0f)));
+		Lanes const down_nearest = Add(Sub(MaskToOne(GreaterEqual(Sub(phase, half), width)), MaskToOne(Less(Add(phase, half), width))), width);
+		value = Add(value, PolyBLEP(Sub(phase, up_nearest), w));
+		value = Sub(value, PolyBLEP(Sub(phase, down_nearest), w));
+	}
+	return value;
+}
+
+// triangle wave
+// (lane version of OscillatorTriangle without sync)
+static __forceinline Lanes Triangle(Lanes const phase, Lanes const delta, bool const antialias)
+{
+	Lanes const cycle = ToFloat(FloorInt(Sub(phase, Set(0.25f))));
+	Lanes value = Sub(Abs(Sub(Mul(Set(4.0f), Sub(phase, cycle)), Set(3.0f))), Set(1.0f));
+	if (antialias)
+	{
+		Lanes const w = Minimum(Mul(delta, Set(INTEGRATED_POLYBLEP_WIDTH)), Set(0.5f));
+		Lanes const down_nearest = Add(MaskToOne(GreaterEqual(phase, Set(0.75f))), Set(0.25f));
+		Lanes const up_nearest = Sub(MaskToOne(GreaterEqual(phase, Set(0.25f))), Set(0.25f));
+		value = Sub(value, IntegratedPolyBLEP(Sub(phase, down_nearest), w));
+		value = Add(value, IntegratedPolyBLEP(Sub(phase, up_nearest), w));
+	}
+	return value;
+}
+
+// oscillator state in structure-of-arrays form
+struct LaneState
+{
+	float phase[NUM_OSCILLATORS][VOICE_BANK_LANES];
+	int index[NUM_OSCILLATORS][VOICE_BANK_LANES];
+
+	// copy one lane from another lane state
+	void CopyLane(LaneState const &from, int const l)
+	{
+		for (int o = 0; o < NUM_OSCILLATORS; ++o)
+		{
+			phase[o][l] = from.phase[o][l];
+			index[o][l] = from.index[o][l];
+		}
+	}
+};
+
+// filter state in structure-of-arrays form
+struct FilterLaneState
+{
+	float z[5][VOICE_BANK_LANES];
+	float y[5][VOICE_BANK_LANES];
+	float previous[VOICE_BANK_LANES];
+
+	// copy one lane from another lane state
+	void CopyLane(FilterLaneState const &from, int const l)
+	{
+		for (int k = 0; k < 5; ++k)
+			z[k][l] = from.z[k][l];
+		for (int k = 0; k < 5; ++k)
+			y[k][l] = from.y[k][l];
+		previous[l] = from.previous[l];
+	}
+};
+
+// filter values ramped toward the next control update, one lane per voice
+// (each filter model ramps up to three coefficients)
+struct FilterLaneRamp
+{
+	float feedback[VOICE_BANK_LANES];
+	float gain[VOICE_BANK_LANES];
+	float coeff[3][VOICE_BANK_LANES];
+	float feedback_step[VOICE_BANK_LANES];
+	float gain_step[VOICE_BANK_LANES];
+	float coeff_step[3][VOICE_BANK_LANES];
+};
+
+// get the ramped coefficients of a filter model
+// (in the order the lane filter uses them)
+static int GetFilterCoefficients(FilterModel const model, FilterState &flt, float *value[3], float *step[3])
+{
+	switch (model)
+	{
+	case FILTER_IMPROVED_MOOG:
+		value[0] = &flt.a1; step[0] = &flt.a1_step;
+		value[1] = &flt.b0; step[1] = &flt.b0_step;
+		value[2] = &flt.b1; step[2] = &flt.b1_step;
+		return 3;
+	case FILTER_LINEAR_MOOG:
+	case FILTER_NONLINEAR_MOOG:
+		value[0] = &flt.tune; step[0] = &flt.tune_step;
+		return 1;
+	default:
+		value[0] = &flt.G; step[0] = &flt.G_step;
+		value[1] = &flt.inv1g; step[1] = &flt.inv1g_step;
+		value[2] = &flt.alpha0; step[2] = &flt.alpha0_step;
+		return 3;
+	}
+}
+
+// find the next voice to finish after a sample
+static size_t NextFinish(size_t const rendered[], int const count, size_t const after, size_t const longest)
+{
+	size_t next = longest;
+	for (int l = 0; l < count; ++l)
+	{
+		if (rendered[l] > after && rendered[l] < next)
+			next = rendered[l];
+	}
+	return next;
+}
+
+// check if the current settings can use the voice bank
+bool VoiceBankSupported()
+{
+	Snapshot const &patch = *render_snapshot;
+
+	if (patch.use_antialias && patch.antialias_method != ANTIALIAS_POLYBLEP)
+		return false;
+	for (int o = 0; o < NUM_OSCILLATORS; ++o)
+	{
+		NoteOscillatorConfig const &config = patch.osc_config[o];
+		if (!config.enable)
+			continue;
+		if (config.wavetype != WAVE_SAWTOOTH && config.wavetype != WAVE_PULSE && config.wavetype != WAVE_TRIANGLE)
+			return false;
+		if (config.sync_enable)
+			return false;
+		if (config.sub_osc_mode && config.sub_osc_amplitude)
+			return false;
+	}
+	return true;
+}
+
+// render amplifier envelopes for a group of voices
+static void RenderEnvelopes(EnvelopeState env[], int const count, float const step, float value[][VOICE_BANK_LANES], size_t const samples, size_t rendered[])
+{
+	Snapshot const &patch = *render_snapshot;
+
+	// a disabled envelope generator follows the gate
+	if (!patch.amp_env_config.enable)
+	{
+		float gate[VOICE_BANK_LANES] = { 0 };
+		for (int l = 0; l < count; ++l)
+		{
+			gate[l] = env[l].gate;
+			rendered[l] = samples;
+		}
+		for (size_t s = 0; s < samples; ++s)
+			memcpy(value[s], gate, sizeof(gate));
+		return;
+	}
+
+	// gather envelope segments
+	// (unused lanes hold at zero; end is the sample that reaches the limit)
+	float amplitude[VOICE_BANK_LANES] = { 0 };
+	float delta[VOICE_BANK_LANES] = { 0 };
+	float target[VOICE_BANK_LANES] = { 0 };
+	float decay[VOICE_BANK_LANES] = { 0 };
+	float limit[VOICE_BANK_LANES] = { 0 };
+	float lower[VOICE_BANK_LANES] = { 0 };
+	float upper[VOICE_BANK_LANES] = { 0 };
+	size_t end[VOICE_BANK_LANES];
+	for (int l = 0; l < VOICE_BANK_LANES; ++l)
+		end[l] = samples;
+	int live = 0;
+	for (int l = 0; l < count; ++l)
+	{
+		size_t const length = env[l].GetSegment(patch.amp_env_config, step, samples, target[l], decay[l], limit[l]);
+		amplitude[l] = env[l].amplitude;
+		delta[l] = amplitude[l] - target[l];
+		lower[l] = Min(limit[l], amplitude[l]);
+		upper[l] = Max(limit[l], amplitude[l]);
+		end[l] = length - 1;
+		rendered[l] = samples;
+		live |= 1 << l;
+	}
+
+	Lanes a = Load(amplitude);
+	Lanes d = Load(delta);
+	Lanes t = Load(target);
+	Lanes r = Load(decay);
+	Lanes lo = Load(lower);
+	Lanes hi = Load(upper);
+
+	size_t s = 0;
+	for (;;)
+	{
+		// find the next sample where a live envelope reaches its limit
+		size_t next = samples;
+		for (int l = 0; l < count; ++l)
+		{
+			if (live & (1 << l))
+				next = Min(next, end[l]);
+		}
+
+		// fill up to that sample from the closed form
+		// (held short of the limits in case rounding reaches them a sample early)
+		for (; s < next; ++s)
+		{
+			d = Sub(d, Mul(d, r));
+			a = Minimum(Maximum(Add(t, d), lo), hi);
+			Store(value[s], a);
+		}
+		if (s >= samples)
+			break;
+
+		// advance each envelope reaching its limit to its next segment
+		d = Sub(d, Mul(d, r));
+		a = Minimum(Maximum(Add(t, d), lo), hi);
+		Store(amplitude, a);
+		Store(delta, d);
+		for (int l = 0; l < count; ++l)
+		{
+			if (!(live & (1 << l)) || end[l] != s)
+				continue;
+			env[l].EndSegment(patch.amp_env_config, limit[l]);
+			if (env[l].state == EnvelopeState::OFF)
+			{
+				rendered[l] = s;
+				live &= ~(1 << l);
+			}
+			size_t const length = env[l].GetSegment(patch.amp_env_config, step, samples - s - 1, target[l], decay[l], limit[l]);
+			amplitude[l] = env[l].amplitude;
+			delta[l] = amplitude[l] - target[l];
+			lower[l] = Min(limit[l], amplitude[l]);
+			upper[l] = Max(limit[l], amplitude[l]);
+			end[l] = s + length;
+		}
+		a = Load(amplitude);
+		d = Load(delta);
+		t = Load(target);
+		r = Load(decay);
+		lo = Load(lower);
+		hi = Load(upper);
+		Store(value[s], a);
+		++s;
+	}
+
+	// update live envelope amplitudes
+	Store(amplitude, a);
+	for (int l = 0; l < count; ++l)
+	{
+		if (live & (1 << l))
+			env[l].amplitude = amplitude[l];
+	}
+}
+
+// a control block for a group of voices
+struct LaneBlock
+{
+	NoteOscillatorConfig const *config;
+	FilterConfig const *flt_config;
+	bool antialias;
+	int const *voice;
+	int count;
+	size_t const *rendered;
+	size_t longest;
+	size_t samples;
+
+	// oscillator state and per-voice constants
+	LaneState osc;
+	float delta[NUM_OSCILLATORS][VOICE_BANK_LANES];
+
+	// filter state and ramps
+	FilterLaneState flt;
+	FilterLaneRamp ramp;
+
+	// state of voices that finished partway through the block
+	LaneState osc_finished;
+	FilterLaneState flt_finished;
+
+	// amplifier envelope values and level
+	float env_value[MAX_CONTROL_SAMPLES][VOICE_BANK_LANES];
+	float level[VOICE_BANK_LANES];
+
+	// output of each voice
+	float signal[MAX_CONTROL_SAMPLES][VOICE_BANK_LANES];
+};
+
+// save the lanes of voices that finished before a sample
+template <typename State> static void SaveFinished(State &finished, State const &current, LaneBlock const &block, size_t const s)
+{
+	for (int l = 0; l < block.count; ++l)
+	{
+		if (block.rendered[l] == s)
+			finished.CopyLane(current, l);
+	}
+}
+
+// oscillator lane registers
+// (keeps its own copy of the settings so lane stores cannot alias them)
+struct OscillatorLanes
+{
+	Lanes phase[NUM_OSCILLATORS];
+	LanesInt index[NUM_OSCILLATORS];
+	Lanes delta[NUM_OSCILLATORS];
+
+	// oscillator amplitude ramps
+	float amplitude[NUM_OSCILLATORS];
+	float amplitude_step[NUM_OSCILLATORS];
+
+	// oscillator settings
+	bool enable[NUM_OSCILLATORS];
+	Wave wavetype[NUM_OSCILLATORS];
+	float waveparam[NUM_OSCILLATORS];
+	bool antialias;
+
+	void Gather(LaneBlock const &block)
+	{
+		for (int o = 0; o < NUM_OSCILLATORS; ++o)
+		{
+			NoteOscillatorConfig const &config = block.config[o];
+			phase[o] = Load(block.osc.phase[o]);
+			index[o] = LoadInt(block.osc.index[o]);
+			delta[o] = Load(block.delta[o]);
+			amplitude[o] = config.amplitude_begin;
+			amplitude_step[o] = (config.amplitude - config.amplitude_begin) / block.samples;
+			enable[o] = config.enable;
+			wavetype[o] = config.wavetype;
+			waveparam[o] = config.waveparam;
+		}
+		antialias = block.antialias;
+	}
+
+	void Scatter(LaneState &state) const
+	{
+		for (int o = 0; o < NUM_OSCILLATORS; ++o)
+		{
+			Store(state.phase[o], phase[o]);
+			StoreInt(state.index[o], index[o]);
+		}
+	}
+
+	// compute the combined oscillator value and advance the oscillators
+	__forceinline Lanes Update()
+	{
+		Lanes value = Set(0.0f);
+		for (int o = 0; o < NUM_OSCILLATORS; ++o)
+		{
+			if (!enable[o])
+				continue;
+
+			// compute oscillator value
+			Lanes wave;
+			switch (wavetype[o])
+			{
+			case WAVE_PULSE:
+				wave = Pulse(phase[o], delta[o], waveparam[o], antialias);
+				break;
+			case WAVE_TRIANGLE:
+				wave = Triangle(phase[o], delta[o], antialias);
+				break;
+			default:
+				wave = Sawtooth(phase[o], delta[o], antialias);
+				break;
+			}
+			wave = AndNot(Less(Set(0.5f), delta[o]), wave);
+			amplitude[o] += amplitude_step[o];
+			value = Add(value, Mul(Set(amplitude[o]), wave));
+
+			// advance oscillator phase
+			// (these waves never wrap the loop index)
+			phase[o] = Add(phase[o], delta[o]);
+			LanesInt const advance = FloorInt(phase[o]);
+			phase[o] = Sub(phase[o], ToFloat(advance));
+			index[o] = AddInt(index[o], advance);
+		}
+		return value;
+	}
+};
+
+// filter lane registers
+// (lane version of FilterState for one filter model and stage count)
+template <FilterModel MODEL, int STAGES> struct FilterLanes
+{
+	// coefficients the filter model ramps
+	static int const COEFFS = (MODEL == FILTER_LINEAR_MOOG || MODEL == FILTER_NONLINEAR_MOOG) ? 1 : 3;
+
+	Lanes z[5], y[5];
+	Lanes previous;
+	Lanes fb, input_gain, c[3];
+	Lanes fb_step, input_gain_step, c_step[3];
+
+	// stage mixing values
+	Lanes mix[5];
+
+	void Gather(LaneBlock const &block)
+	{
+		for (int k = 0; k < 5; ++k)
+			mix[k] = Set(block.flt_config->mix[k]);
+		for (int k = 0; k < 5; ++k)
+			z[k] = Load(block.flt.z[k]);
+		for (int k = 0; k < 5; ++k)
+			y[k] = Load(block.flt.y[k]);
+		previous = Load(block.flt.previous);
+		fb = Load(block.ramp.feedback);
+		input_gain = Load(block.ramp.gain);
+		fb_step = Load(block.ramp.feedback_step);
+		input_gain_step = Load(block.ramp.gain_step);
+		for (int k = 0; k < COEFFS; ++k)
+		{
+			c[k] = Load(block.ramp.coeff[k]);
+			c_step[k] = Load(block.ramp.coeff_step[k]);
+		}
+	}
+
+	// (stages past STAGES settle on the last computed stage, as in FilterState::Settle)
+	void Scatter(FilterLaneState &state) const
+	{
+		for (int k = 0; k < 5; ++k)
+		{
+			Lanes value = z[k];
+			if (MODEL == FILTER_NONLINEAR_MOOG && k > STAGES)
+				value = z[STAGES];
+			else if (MODEL == FILTER_TPT_MOOG && k >= STAGES && k < 4)
+				value = y[STAGES];
+			Store(state.z[k], value);
+		}
+		for (int k = 0; k < 5; ++k)
+			Store(state.y[k], y[Min(k, STAGES)]);
+		Store(state.previous, STAGES < 4 ? y[STAGES] : previous);
+	}
+
+	// step the filter values toward the next control update
+	__forceinline void Ramp()
+	{
+		fb = Add(fb, fb_step);
+		input_gain = Add(input_gain, input_gain_step);
+		for (int k = 0; k < COEFFS; ++k)
+			c[k] = Add(c[k], c_step[k]);
+	}
+
+	// advance the filter by one oversampled step
+	// (lane version of FilterState::Step and FilterState::Mix)
+	__forceinline Lanes Update(Lanes const input)
+	{
+		// input with drive and gain compensation
+		Lanes const input_adjusted = Mul(input, input_gain);
+
+		if (MODEL == FILTER_IMPROVED_MOOG)
+		{
+			// nonlinear feedback with gain compensation
+			Lanes const in = FastTanh(Sub(input_adjusted, Mul(fb, y[4])));
+
+			// four-pole low-pass filter
+			// (c[0] = a1, c[1] = b0, c[2] = b1)
+			Lanes const t[4] = { y[0], y[1], y[2], y[3] };
+			y[0] = in;
+			for (int k = 0; k < STAGES; ++k)
+				y[k + 1] = Add(Add(Mul(y[k + 1], c[0]), Mul(y[k], c[1])), Mul(t[k], c[2]));
+		}
+		else if (MODEL == FILTER_LINEAR_MOOG)
+		{
+			// half-sample delay for phase compensation
+			Lanes const delayed = Mul(Set(0.5f), Add(y[4], previous));
+			previous = y[4];
+
+			// nonlinear feedback with gain compensation
+			y[0] = FastTanh(Sub(input_adjusted, Mul(fb, delayed)));
+
+			// four-pole low-pass filter
+			// (c[0] = tune)
+			for (int k = 0; k < STAGES; ++k)
+				y[k + 1] = Add(y[k + 1], Mul(c[0], Sub(y[k], y[k + 1])));
+		}
+		else if (MODEL == FILTER_NONLINEAR_MOOG)
+		{
+			// half-sample delay for phase compensation
+			Lanes const delayed = Mul(Set(0.5f), Add(y[4], previous));
+			previous = y[4];
+
+			// nonlinear feedback with gain compensation
+			y[0] = Sub(input_adjusted, Mul(fb, delayed));
+			z[0] = FastTanh(Mul(y[0], Set(0.8192f)));
+
+			// nonlinear four-pole low-pass filter
+			// (c[0] = tune)
+			for (int k = 0; k < STAGES; ++k)
+			{
+				y[k + 1] = Add(y[k + 1], Mul(c[0], Sub(z[k], z[k + 1])));
+				z[k + 1] = FastTanh(Mul(y[k + 1], Set(0.8192f)));
+			}
+		}
+		else if (MODEL == FILTER_TPT_MOOG)
+		{
+			// nonlinear feedback with gain compensation
+			// (c[0] = G, c[1] = inv1g, c[2] = alpha0)
+			Lanes const S = Mul(Add(Mul(Add(Mul(Add(Mul(z[0], c[0]), z[1]), c[0]), z[2]), c[0]), z[3]), c[1]);
+			y[0] = FastTanh(Mul(c[2], Sub(input_adjusted, Mul(fb, S))));
+
+			// four-pole low-pass filter
+			for (int k = 0; k < STAGES; ++k)
+			{
+				Lanes const v = Mul(Sub(y[k], z[k]), c[0]);
+				y[k + 1] = Add(v, z[k]);
+				z[k] = Add(y[k + 1], v);
+			}
+		}
+
+		// generate output by mixing stage values
+		Lanes value = Mul(y[0], mix[0]);
+		for (int k = 1; k <= STAGES; ++k)
+			value = Add(value, Mul(y[k], mix[k]));
+		return value;
+	}
+};
+
+// render the voices of a control block
+// (MODEL is FILTER_MODEL_COUNT without the filter)
+template <FilterModel MODEL, int OVERSAMPLE, int STAGES> static void RenderLanes(LaneBlock &block)
+{
+	bool const filter = MODEL != FILTER_MODEL_COUNT;
+
+	OscillatorLanes osc;
+	osc.Gather(block);
+	FilterLanes<MODEL, STAGES> flt;
+	if (filter)
+		flt.Gather(block);
+	Lanes const amp_level = Load(block.level);
+
+	// block values kept out of reach of the lane stores
+	size_t const longest = block.longest;
+	float (* const signal)[VOICE_BANK_LANES] = block.signal;
+	float const (* const env_value)[VOICE_BANK_LANES] = block.env_value;
+
+	if (OVERSAMPLE == 1)
+	{
+		// run oscillators, filter, and amplifier together
+		// (the oscillators fill in around the filter's dependency chain)
+		size_t next_finish = NextFinish(block.rendered, block.count, 0, longest);
+		for (size_t s = 0; s < longest; ++s)
+		{
+			// if any voice finished before this sample...
+			if (s == next_finish)
+			{
+				// save the state of the finished voices
+				LaneState current;
+				osc.Scatter(current);
+				SaveFinished(block.osc_finished, current, block, s);
+				if (filter)
+				{
+					FilterLaneState flt_current;
+					flt.Scatter(flt_current);
+					SaveFinished(block.flt_finished, flt_current, block, s);
+				}
+				next_finish = NextFinish(block.rendered, block.count, s, longest);
+			}
+
+			Lanes value = osc.Update();
+			if (filter)
+			{
+				flt.Ramp();
+				value = flt.Update(value);
+			}
+
+			// apply amplifier level
+			Store(signal[s], Mul(value, Mul(Load(env_value[s]), amp_level)));
+		}
+	}
+	else
+	{
+		// run oscillators
+		size_t next_finish = NextFinish(block.rendered, block.count, 0, longest);
+		for (size_t s = 0; s < longest; ++s)
+		{
+			if (s == next_finish)
+			{
+				LaneState current;
+				osc.Scatter(current);
+				SaveFinished(block.osc_finished, current, block, s);
+				next_finish = NextFinish(block.rendered, block.count, s, longest);
+			}
+			Store(signal[s], osc.Update());
+		}
+
+		// upsample each voice with its own oversampler
+		// (samples past the end of a voice stay silent)
+		float upsampled[OVERSAMPLE_BLOCK * OVERSAMPLE_MAX][VOICE_BANK_LANES];
+		memset(upsampled, 0, longest * OVERSAMPLE * sizeof(upsampled[0]));
+		float source[OVERSAMPLE_BLOCK * OVERSAMPLE_MAX];
+		float target[OVERSAMPLE_BLOCK * OVERSAMPLE_MAX];
+		for (int l = 0; l < block.count; ++l)
+		{
+			size_t const rendered = block.rendered[l];
+			if (rendered == 0)
+				continue;
+			for (size_t s = 0; s < rendered; ++s)
+				source[s] = signal[s][l];
+			flt_state[block.voice[l]].oversampler.Upsample(OVERSAMPLE, source, target, rendered);
+			for (size_t s = 0; s < rendered * OVERSAMPLE; ++s)
+				upsampled[s][l] = target[s];
+		}
+
+		// run the filter at the oversampled rate
+		next_finish = NextFinish(block.rendered, block.count, 0, longest);
+		for (size_t s = 0; s < longest; ++s)
+		{
+			if (s == next_finish)
+			{
+				FilterLaneState flt_current;
+				flt.Scatter(flt_current);
+				SaveFinished(block.flt_finished, flt_current, block, s);
+				next_finish = NextFinish(block.rendered, block.count, s, longest);
+			}
+			flt.Ramp();
+			for (int i = 0; i < OVERSAMPLE; ++i)
+			{
+				float *sample = upsampled[s * OVERSAMPLE + i];
+				Store(sample, flt.Update(Load(sample)));
+			}
+		}
+
+		// downsample each voice
+		for (int l = 0; l < block.count; ++l)
+		{
+			size_t const rendered = block.rendered[l];
+			if (rendered == 0)
+				continue;
+			for (size_t s = 0; s < rendered * OVERSAMPLE; ++s)
+				source[s] = upsampled[s][l];
+			flt_state[block.voice[l]].oversampler.Downsample(OVERSAMPLE, source, target, rendered);
+			for (size_t s = 0; s < rendered; ++s)
+				signal[s][l] = target[s];
+		}
+
+		// apply amplifier level
+		for (size_t s = 0; s < longest; ++s)
+			Store(signal[s], Mul(Load(signal[s]), Mul(Load(env_value[s]), amp_level)));
+	}
+
+	osc.Scatter(block.osc);
+	if (filter)
+		flt.Scatter(block.flt);
+}
+
+// render the voices of a control block computing only the filter stages needed
+template <FilterModel MODEL, int OVERSAMPLE> static void RenderLanes(LaneBlock &block, int const stages)
+{
+	switch (stages)
+	{
+	case 1:		RenderLanes<MODEL, OVERSAMPLE, 1>(block); break;
+	case 2:		RenderLanes<MODEL, OVERSAMPLE, 2>(block); break;
+	case 3:		RenderLanes<MODEL, OVERSAMPLE, 3>(block); break;
+	default:	RenderLanes<MODEL, OVERSAMPLE, 4>(block); break;
+	}
+}
+
+// render the voices of a control block at the configured oversampling factor
+template <FilterModel MODEL> static void RenderLanes(LaneBlock &block, int const oversample, int const stages)
+{
+	switch (oversample)
+	{
+	case 4:		RenderLanes<MODEL, 4>(block, stages); break;
+	case 2:		RenderLanes<MODEL, 2>(block, stages); break;
+	default:	RenderLanes<MODEL, 1>(block, stages); break;
+	}
+}
+
+// render a control block for a group of voices
+void VoiceBankRender(int const voice[], int const count, NoteOscillatorConfig const config[NUM_OSCILLATORS], float const osc_key_freq[][NUM_OSCILLATORS], float const flt_key_freq[], float const lfo, float const step, float bus[], size_t const samples, size_t rendered[], float peak[])
+{
+	Snapshot const &patch = *render_snapshot;
+
+	assert(count > 0 && count <= VOICE_BANK_LANES);
+	assert(samples <= MAX_CONTROL_SAMPLES && samples <= OVERSAMPLE_BLOCK);
+
+	for (int l = 0; l < count; ++l)
+		peak[l] = 0.0f;
+
+	LaneBlock block;
+
+	// update amplifier envelopes
+	EnvelopeState env[VOICE_BANK_LANES];
+	for (int l = 0; l < count; ++l)
+		env[l] = amp_env_state[voice[l]];
+	RenderEnvelopes(env, count, step, block.env_value, samples, rendered);
+	for (int l = 0; l < count; ++l)
+		amp_env_state[voice[l]] = env[l];
+
+	// longest rendered voice
+	size_t longest = 0;
+	for (int l = 0; l < count; ++l)
+		longest = Max(longest, rendered[l]);
+	if (longest == 0)
+		return;
+
+	block.config = config;
+	block.flt_config = &patch.flt_config;
+	block.antialias = patch.use_antialias;
+	block.voice = voice;
+	block.count = count;
+	block.rendered = rendered;
+	block.longest = longest;
+	block.samples = samples;
+
+	// gather voice state and per-voice constants
+	// (unused lanes stay silent)
+	bool const filter = patch.flt_config.enable;
+	int stages = 1;
+	memset(&block.osc, 0, sizeof(block.osc));
+	memset(block.delta, 0, sizeof(block.delta));
+	memset(block.level, 0, sizeof(block.level));
+	if (filter)
+	{
+		memset(&block.flt, 0, sizeof(block.flt));
+		memset(&block.ramp, 0, sizeof(block.ramp));
+	}
+	for (int l = 0; l < count; ++l)
+	{
+		int const v = voice[l];
+
+		// key velocity
+		float const key_vel = voice_vel[v] / 64.0f;
+
+		for (int o = 0; o < NUM_OSCILLATORS; ++o)
+		{
+			OscillatorState const &osc = osc_state[v][o];
+			block.osc.phase[o][l] = osc.phase;
+			block.osc.index[o][l] = osc.index;
+			float const key_step = osc_key_freq[v][o] * step;
+			block.delta[o][l] = config[o].frequency * config[o].adjust * key_step;
+		}
+
+		if (filter && rendered[l] > 0)
+		{
+			// update filter envelope generator
+			float const flt_env_amplitude = flt_env_state[v].Update(patch.flt_env_config, step * samples);
+
+			// compute cutoff frequency
+			float const cutoff = flt_key_freq[v] * patch.flt_config.GetCutoff(lfo, flt_env_amplitude, key_vel);
+
+			// ramp the filter to the new cutoff over the block
+			FilterState &flt = flt_state[v];
+			flt.Ramp(patch.flt_config, cutoff, patch.flt_config.resonance, step, samples);
+			stages = Max(stages, flt.GetStages(patch.flt_config));
+			FilterLaneRamp &ramp = block.ramp;
+			ramp.feedback[l] = flt.feedback;
+			ramp.gain[l] = patch.flt_config.drive * (1.0f + flt.feedback * patch.flt_config.compensation);
+			ramp.feedback_step[l] = flt.feedback_step;
+			ramp.gain_step[l] = patch.flt_config.drive * flt.feedback_step * patch.flt_config.compensation;
+			float *coeff[3], *coeff_step[3];
+			int const coeffs = GetFilterCoefficients(patch.flt_config.model, flt, coeff, coeff_step);
+			for (int k = 0; k < coeffs; ++k)
+			{
+				ramp.coeff[k][l] = *coeff[k];
+				ramp.coeff_step[k][l] = *coeff_step[k];
+			}
+
+			// the lanes finish the ramp
+			flt.feedback += flt.feedback_step * samples;
+			for (int k = 0; k < coeffs; ++k)
+				*coeff[k] += *coeff_step[k] * samples;
+			for (int k = 0; k < 5; ++k)
+				block.flt.z[k][l] = flt.z[k];
+			for (int k = 0; k < 5; ++k)
+				block.flt.y[k][l] = flt.y[k];
+			block.flt.previous[l] = flt.previous;
+		}
+
+		block.level[l] = patch.amp_config.level_env + key_vel * patch.amp_config.level_env_vel;
+	}
+
+	// render oscillators, filter, and amplifier
+	// (dispatches once per block)
+	int const oversample = patch.flt_config.GetOversample();
+	switch (filter ? patch.flt_config.model : FILTER_MODEL_COUNT)
+	{
+	case FILTER_IMPROVED_MOOG:	RenderLanes<FILTER_IMPROVED_MOOG>(block, oversample, stages); break;
+	case FILTER_LINEAR_MOOG:	RenderLanes<FILTER_LINEAR_MOOG>(block, oversample, stages); break;
+	case FILTER_NONLINEAR_MOOG:	RenderLanes<FILTER_NONLINEAR_MOOG>(block, oversample, stages); break;
+	case FILTER_TPT_MOOG:		RenderLanes<FILTER_TPT_MOOG>(block, oversample, stages); break;
+	default:					RenderLanes<FILTER_MODEL_COUNT, 1, 4>(block); break;
+	}
+
+	// scatter voice state
+	for (int l = 0; l < count; ++l)
+	{
+		if (rendered[l] == 0)
+			continue;
+		if (rendered[l] < longest)
+		{
+			block.osc.CopyLane(block.osc_finished, l);
+			if (filter)
+				block.flt.CopyLane(block.flt_finished, l);
+		}
+
+		int const v = voice[l];
+		for (int o = 0; o < NUM_OSCILLATORS; ++o)
+		{
+			if (!config[o].enable)
+				continue;
+			osc_state[v][o].phase = block.osc.phase[o][l];
+			osc_state[v][o].index = block.osc.index[o][l];
+		}
+		if (filter)
+		{
+			FilterState &flt = flt_state[v];
+			for (int k = 0; k < 5; ++k)
+				flt.z[k] = block.flt.z[k][l];
+			for (int k = 0; k < 5; ++k)
+				flt.y[k] = block.flt.y[k][l];
+			flt.previous = block.flt.previous[l];
+		}
+	}
+
+	// accumulate results in voice order
+	for (size_t s = 0; s < samples; ++s)
+	{
+		for (int l = 0; l < count; ++l)
+		{
+			if (s < rendered[l])
+			{
+				bus[s] += block.signal[s][l];
+				peak[l] = Max(peak[l], fabsf(block.signal[s][l]));
+			}
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,45 @@
+#pragma once
+/*
+MINI VIRTUAL ANALOG SYNTHESIZER
+Copyright 2014 Kenneth D. Miller III
+
+Voice Bank
+*/
+
+#include "OscillatorNote.h"
+#include "Filter.h"
+
+// The voice bank renders groups of voices in parallel, one voice per SIMD
+// lane.  Voice state is gathered from the per-voice arrays into structure-of-
+// arrays form at the start of each control block and scattered back at the
+// end, so the rest of the synthesizer keeps working on individual voices.
+
+// voices per lane group
+#if defined(__AVX2__)
+#define VOICE_BANK_LANES 8
+#elif _M_IX86_FP > 0
+#define VOICE_BANK_LANES 4
+#else
+#define VOICE_BANK_LANES 1
+#endif
+
+// voice bank availability
+// (requires SIMD support)
+#define VOICE_BANK (VOICE_BANK_LANES > 1)
+
+#if VOICE_BANK
+
+// check if the current settings can use the voice bank
+// (sawtooth, pulse, and triangle oscillators without sync or sub-oscillator,
+// and PolyBLEP antialiasing; every filter model runs in the lanes)
+extern bool VoiceBankSupported();
+
+// render a control block for a group of voices and add it to the bus
+// voice: voice indices for the group (up to VOICE_BANK_LANES)
+// config: modulated oscillator configuration for the block
+// rendered: receives the number of samples each voice rendered before its
+// amplifier envelope finished
+// peak: receives the largest output magnitude of each voice
+extern void VoiceBankRender(int const voice[], int const count, NoteOscillatorConfig const config[NUM_OSCILLATORS], float const osc_key_freq[][NUM_OSCILLATORS], float const flt_key_freq[], float const lfo, float const step, float bus[], size_t const samples, size_t rendered[], float peak[]);
+
+#endif
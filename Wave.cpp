@@ -7,6 +7,7 @@ Wave Types
 #include "StdAfx.h"
 
 #include "Wave.h"
+#include "Oscillator.h"
 #include "WaveSine.h"
 #include "WavePulse.h"
 #include "WaveSawtooth.h"
@@ -14,9 +15,21 @@ Wave Types
 #include "WaveNoise.h"
 #include "WavePoly.h"
 #include "WaveHold.h"
+#include "Wavetable.h"
+#include "Snapshot.h"
 
 // waveform antialiasing
 bool use_antialias = true;
+int antialias_method = ANTIALIAS_POLYBLEP;
+
+// turn antialiasing on with the given method, or off with ANTIALIAS_NONE
+// (turning it off keeps the method for when it comes back on)
+void SetAntialias(int const method)
+{
+	use_antialias = method != ANTIALIAS_NONE;
+	if (use_antialias)
+		antialias_method = method;
+}
 
 // map wave type enumeration to oscillator function
 WaveEvaluate const wave_evaluate[WAVE_COUNT] =
@@ -39,6 +52,33 @@ WaveEvaluate const wave_evaluate[WAVE_COUNT] =
 	OscillatorPoly,			// WAVE_POLY17_POLY5,
 };
 
+// map wave type enumeration to block renderers
+WaveRenderTable * const wave_render[WAVE_COUNT] =
+{
+	&sine_render,			// WAVE_SINE,
+	&pulse_render,			// WAVE_PULSE,
+	&sawtooth_render,		// WAVE_SAWTOOTH,
+	&triangle_render,		// WAVE_TRIANGLE,
+	&noise_render,			// WAVE_NOISE,
+	&noise_hold_render,		// WAVE_NOISE_HOLD
+	&noise_linear_render,	// WAVE_NOISE_LINEAR
+	&noise_cubic_render,	// WAVE_NOISE_CUBIC
+	&poly_render,			// WAVE_POLY4,
+	&poly_render,			// WAVE_POLY5,
+	&poly_render,			// WAVE_PERIOD93,
+	&poly_render,			// WAVE_POLY9,
+	&poly_render,			// WAVE_POLY17,
+	&poly_render,			// WAVE_PULSE_POLY5,
+	&poly_render,			// WAVE_POLY4_POLY5,
+	&poly_render,			// WAVE_POLY17_POLY5,
+};
+
+// get the block renderer for the current settings
+WaveRender GetWaveRender(OscillatorConfig const &config)
+{
+	return (*wave_render[config.wavetype])[render_snapshot->GetAntialias()][config.sync_enable];
+}
+
 // names for wave types
 char const * const wave_name[WAVE_COUNT] =
 {
@@ -96,18 +136,19 @@ int const wave_loop_cycle[WAVE_COUNT] =
 	ARRAY_SIZE(noise),			// WAVE_NOISE_HOLD
 	ARRAY_SIZE(noise),			// WAVE_NOISE_LINEAR
 	ARRAY_SIZE(noise),			// WAVE_NOISE_CUBIC
-	ARRAY_SIZE(poly4),			// WAVE_POLY4,
-	ARRAY_SIZE(poly5),			// WAVE_POLY5,
-	ARRAY_SIZE(period93),		// WAVE_PERIOD93,
-	ARRAY_SIZE(poly9),			// WAVE_POLY9,
-	ARRAY_SIZE(poly17),			// WAVE_POLY17,
-	ARRAY_SIZE(pulsepoly5),		// WAVE_PULSE_POLY5,
-	ARRAY_SIZE(poly4poly5),		// WAVE_POLY4_POLY5,
-	ARRAY_SIZE(poly17poly5),	// WAVE_POLY17_POLY5,
+	POLY4_LENGTH,				// WAVE_POLY4,
+	POLY5_LENGTH,				// WAVE_POLY5,
+	PERIOD93_LENGTH,			// WAVE_PERIOD93,
+	POLY9_LENGTH,				// WAVE_POLY9,
+	POLY17_LENGTH,				// WAVE_POLY17,
+	PULSE_POLY5_LENGTH,			// WAVE_PULSE_POLY5,
+	POLY4_POLY5_LENGTH,			// WAVE_POLY4_POLY5,
+	POLY17_POLY5_LENGTH,		// WAVE_POLY17_POLY5,
 };
 
 void InitWave()
 {
-	InitPoly();
-	InitNoise();
+	InitWavetables();
+	InitPolyIntegrals();
+	InitNoiseIntegrals();
 }
@@ -7,11 +7,23 @@ Wave Types
 */
 
 // waveform antialiasing
+// (the edited settings; the render thread reads its snapshot's copy)
 #define ANTIALIAS_NONE 0
 #define ANTIALIAS_POLYBLEP 1
+#define ANTIALIAS_MINBLEP 2
+#define ANTIALIAS_WAVETABLE 3
 #define ANTIALIAS 1
 extern bool use_antialias;
 
+// antialiasing method when enabled: ANTIALIAS_POLYBLEP, ANTIALIAS_MINBLEP, or
+// ANTIALIAS_WAVETABLE
+// (minBLEP and wavetables cover block-rendered pulse, sawtooth, and triangle
+// waves without hard sync; everything else keeps using PolyBLEP)
+extern int antialias_method;
+
+// turn antialiasing on with the given method, or off with ANTIALIAS_NONE
+extern void SetAntialias(int const method);
+
 // oscillator wave types
 enum Wave
 {
@@ -45,6 +57,21 @@ typedef float(*WaveEvaluate)(OscillatorConfig const &config, OscillatorState &st
 // map wave type to wave evaluator
 extern WaveEvaluate const wave_evaluate[WAVE_COUNT];
 
+// wave block renderer: adds a block of wave output to the buffer
+// (delta is the phase step per sample, constant over the block)
+typedef void(*WaveRender)(OscillatorConfig const &config, OscillatorState &state, float delta, float buffer[], size_t count);
+
+// block renderers for each wave type, specialized for the antialias and
+// sync settings and indexed by [antialias method][sync]
+typedef WaveRender const WaveRenderTable[4][2];
+
+// map wave type to block renderers
+extern WaveRenderTable * const wave_render[WAVE_COUNT];
+
+// get the block renderer for the current settings
+// (antialiasing follows the render snapshot; render thread only)
+extern WaveRender GetWaveRender(OscillatorConfig const &config);
+
 // names for wave types
 extern char const * const wave_name[WAVE_COUNT];
 
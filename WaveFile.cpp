@@ -0,0 +1,145 @@
+/*
+MINI VIRTUAL ANALOG SYNTHESIZER
+Copyright 2014 Kenneth D. Miller III
+
+Wave File Output
+*/
+#include "StdAfx.h"
+
+#include "WaveFile.h"
+#include "Math.h"
+
+// RIFF WAVE file format
+// http://www-mmsp.ece.mcgill.ca/Documents/AudioFormats/WAVE/WAVE.html
+
+namespace WaveFile
+{
+	// bytes per sample for each format
+	static int const format_bytes[FORMAT_COUNT] = { 3, 4 };
+
+	// wave format tag for each format
+	static int const format_tag[FORMAT_COUNT] = { 1, 3 };	// WAVE_FORMAT_PCM, WAVE_FORMAT_IEEE_FLOAT
+
+	// little-endian output helpers
+	static void Put16(unsigned char *&out, unsigned int value)
+	{
+		*out++ = (unsigned char)(value);
+		*out++ = (unsigned char)(value >> 8);
+	}
+	static void Put32(unsigned char *&out, unsigned int value)
+	{
+		*out++ = (unsigned char)(value);
+		*out++ = (unsigned char)(value >> 8);
+		*out++ = (unsigned char)(value >> 16);
+		*out++ = (unsigned char)(value >> 24);
+	}
+
+	Writer::Writer()
+		: file(NULL)
+		, rate(0)
+		, channels(0)
+		, format(FORMAT_FLOAT32)
+		, frames(0)
+	{
+	}
+
+	Writer::~Writer()
+	{
+		Close();
+	}
+
+	// write the RIFF header
+	// (called again on close to fill in the sizes)
+	bool Writer::WriteHeader()
+	{
+		unsigned int const block_align = channels * format_bytes[format];
+		unsigned int const data_size = frames * block_align;
+
+		unsigned char header[44];
+		unsigned char *out = header;
+		memcpy(out, "RIFF", 4); out += 4;
+		Put32(out, 36 + data_size);
+		memcpy(out, "WAVE", 4); out += 4;
+		memcpy(out, "fmt ", 4); out += 4;
+		Put32(out, 16);
+		Put16(out, format_tag[format]);
+		Put16(out, channels);
+		Put32(out, rate);
+		Put32(out, rate * block_align);
+		Put16(out, block_align);
+		Put16(out, format_bytes[format] * 8);
+		memcpy(out, "data", 4); out += 4;
+		Put32(out, data_size);
+
+		fseek(file, 0, SEEK_SET);
+		return fwrite(header, sizeof(header), 1, file) == 1;
+	}
+
+	// open a file for writing
+	bool Writer::Open(char const *filename, int const aRate, int const aChannels, Format const aFormat)
+	{
+		Close();
+		file = fopen(filename, "wb");
+		if (!file)
+			return false;
+		rate = aRate;
+		channels = aChannels;
+		format = aFormat;
+		frames = 0;
+		return WriteHeader();
+	}
+
+	// write interleaved samples
+	bool Writer::Write(float const buffer[], size_t const count)
+	{
+		if (!file)
+			return false;
+
+		// convert in chunks
+		unsigned char chunk[4096 * 3];
+		size_t const bytes = format_bytes[format];
+		size_t const chunk_samples = sizeof(chunk) / bytes;
+		size_t const samples = count * channels;
+		for (size_t base = 0; base < samples; base += chunk_samples)
+		{
+			size_t const n = Min(chunk_samples, samples - base);
+			unsigned char *out = chunk;
+			if (format == FORMAT_FLOAT32)
+			{
+				for (size_t i = 0; i < n; ++i)
+				{
+					union { float f; unsigned int u; } floatint;
+					floatint.f = buffer[base + i];
+					Put32(out, floatint.u);
+				}
+			}
+			else
+			{
+				for (size_t i = 0; i < n; ++i)
+				{
+					// clamp and round to 24 bits
+					float const sample = Clamp(buffer[base + i], -1.0f, 1.0f) * 8388607.0f;
+					unsigned int const value = (unsigned int)(RoundInt(sample));
+					*out++ = (unsigned char)(value);
+					*out++ = (unsigned char)(value >> 8);
+					*out++ = (unsigned char)(value >> 16);
+				}
+			}
+			if (fwrite(chunk, bytes, n, file) != n)
+				return false;
+		}
+		frames += (unsigned int)(count);
+		return true;
+	}
+
+	// finish the file
+	bool Writer::Close()
+	{
+		if (!file)
+			return true;
+		bool const ok = WriteHeader();
+		fclose(file);
+		file = NULL;
+		return ok;
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+/*
+MINI VIRTUAL ANALOG SYNTHESIZER
+Copyright 2014 Kenneth D. Miller III
+
+Wave File Output
+*/
+
+namespace WaveFile
+{
+	// sample formats
+	enum Format
+	{
+		FORMAT_PCM24,	// 24-bit signed integer
+		FORMAT_FLOAT32,	// 32-bit floating point
+
+		FORMAT_COUNT
+	};
+
+	// wave file writer
+	class Writer
+	{
+	public:
+		Writer();
+		~Writer();
+
+		// open a file for writing
+		bool Open(char const *filename, int const rate, int const channels, Format const format);
+
+		// write interleaved samples
+		// (count is the number of sample frames)
+		bool Write(float const buffer[], size_t const count);
+
+		// finish the file
+		bool Close();
+
+	private:
+		FILE *file;
+		int rate;
+		int channels;
+		Format format;
+		unsigned int frames;
+
+		bool WriteHeader();
+	};
+}
@@ -5,30 +5,44 @@
 #include "PolyBLEP.h"
 #include "Oscillator.h"
 #include "Math.h"
-#include "Random.h"
 
-// precomputed noise wavetable
-float noise[65536];
+// twice the running sum of running sums of the noise table before each sample
+// (see HeldIntegral; the extra entry covers the full period)
+static double *noise_sum2;
 
-// initialize noise wavetable
-void InitNoise()
+// running sum of the noise table over the full period
+static double noise_total;
+
+// PolyBLEP window half-width above which sample-and-hold noise uses its
+// running sums
+#define NOISE_INTEGRAL_WIDTH 1.0f
+
+// twice the second integral of the noise table at the index plus an offset
+static __forceinline double IntegrateNoise(int const index, double const offset)
 {
-	for (int i = 0; i < ARRAY_SIZE(noise); ++i)
-	{
-		noise[i] = Random::Float() * 2.0f - 1.0f;
-	}
+	int const length = NOISE_LENGTH;
+
+	// split the position into periods, samples, and a fraction
+	int advance = int(offset);
+	if (advance > offset)
+		--advance;
+	double const f = offset - advance;
+	int const q = (index + advance) >> NOISE_LOG2_LENGTH;
+	int const r = (index + advance) & (length - 1);
+
+	// running sum recovered from the neighboring sum2 entries
+	double const sum2 = noise_sum2[r];
+	double const sum = 0.5 * (noise_sum2[r + 1] - sum2 - noise[r]);
+	return HeldIntegral(q, r, f, sum, sum2, noise[r], length, noise_total, noise_sum2[length]);
 }
 
 // shared data oscillator
-static float OscillatorHold(OscillatorConfig const &config, OscillatorState &state, float data[], int cycle, float step)
+template <bool ANTIALIASED> static __forceinline float OscillatorHold(OscillatorConfig const &config, OscillatorState &state, float const data[], int cycle, float step)
 {
-	if (step > 0.5f * cycle)
-		return 0;
-
 	// current wavetable value
 	float value = data[state.index];
 #if ANTIALIAS == ANTIALIAS_POLYBLEP
-	if (use_antialias)
+	if (ANTIALIASED)
 	{
 		float w = Min(step * POLYBLEP_WIDTH, 8.0f);
 
@@ -59,11 +73,8 @@ static float OscillatorHold(OscillatorConfig const &config, OscillatorState &sta
 }
 
 // shared data oscillator
-static float OscillatorLerp(OscillatorConfig const &config, OscillatorState &state, float data[], int cycle, float step)
+template <bool ANTIALIASED> static __forceinline float OscillatorLerp(OscillatorConfig const &config, OscillatorState &state, float const data[], int cycle, float step)
 {
-	if (step > 0.5f * cycle)
-		return 0;
-
 	// current and next wavetable value
 	int const index0 = state.index;
 	float const value0 = data[index0];
@@ -72,7 +83,7 @@ static float OscillatorLerp(OscillatorConfig const &config, OscillatorState &sta
 	float value = value0 + (value1 - value0) * state.phase;
 
 #if ANTIALIAS == ANTIALIAS_POLYBLEP
-	if (use_antialias)
+	if (ANTIALIASED)
 	{
 		float w = Min(step * INTEGRATED_POLYBLEP_WIDTH, 8.0f);
 
@@ -109,11 +120,8 @@ static float OscillatorLerp(OscillatorConfig const &config, OscillatorState &sta
 }
 
 // shared data oscillator
-static float OscillatorCubic(OscillatorConfig const &config, OscillatorState &state, float data[], int cycle, float step)
+static __forceinline float OscillatorCubic(OscillatorConfig const &config, OscillatorState &state, float const data[], int cycle, float step)
 {
-	if (step > 0.5f * cycle)
-		return 0;
-
 	// four consecutive wavetable values
 	register int index = state.index;
 	register float const value0 = data[index];
@@ -138,20 +146,132 @@ static float OscillatorCubic(OscillatorConfig const &config, OscillatorState &st
 	return value;
 }
 
+// highest phase step sample-and-hold noise can represent
+// (with running sums, the filtered noise settles to its average at high steps
+// instead of aliasing)
+template <bool ANTIALIASED> static __forceinline float GetNoiseHoldLimit()
+{
+#if ANTIALIAS == ANTIALIAS_POLYBLEP
+	if (ANTIALIASED)
+		return FLT_MAX;
+#endif
+	return 0.5f * ARRAY_SIZE(noise);
+}
+
 // sample-and-hold noise
+template <bool ANTIALIASED> static __forceinline float EvaluateNoiseHold(OscillatorConfig const &config, OscillatorState &state, float step)
+{
+#if ANTIALIAS == ANTIALIAS_POLYBLEP
+	if (ANTIALIASED)
+	{
+		float const w = step * POLYBLEP_WIDTH;
+		if (w > NOISE_INTEGRAL_WIDTH)
+		{
+			// filter through the running sums
+			double const phase = state.phase;
+			double const before = IntegrateNoise(state.index, phase - w);
+			double const at = IntegrateNoise(state.index, phase);
+			double const after = IntegrateNoise(state.index, phase + w);
+			return HeldFilter(before, at, after, w);
+		}
+	}
+#endif
+	return OscillatorHold<ANTIALIASED>(config, state, noise, ARRAY_SIZE(noise), step);
+}
 float OscillatorNoiseHold(OscillatorConfig const &config, OscillatorState &state, float step)
 {
-	return OscillatorHold(config, state, noise, ARRAY_SIZE(noise), step);
+	if (!use_antialias)
+	{
+		if (step > GetNoiseHoldLimit<false>())
+			return 0;
+		return EvaluateNoiseHold<false>(config, state, step);
+	}
+	if (step > GetNoiseHoldLimit<true>())
+		return 0;
+	return EvaluateNoiseHold<true>(config, state, step);
 }
 
 // linear interpolated noise
+template <bool ANTIALIASED> static __forceinline float EvaluateNoiseLinear(OscillatorConfig const &config, OscillatorState &state, float step)
+{
+	return OscillatorLerp<ANTIALIASED>(config, state, noise, ARRAY_SIZE(noise), step);
+}
 float OscillatorNoiseLinear(OscillatorConfig const &config, OscillatorState &state, float step)
 {
-	return OscillatorLerp(config, state, noise, ARRAY_SIZE(noise), step);
+	if (step > 0.5f * ARRAY_SIZE(noise))
+		return 0;
+	if (!use_antialias)
+		return EvaluateNoiseLinear<false>(config, state, step);
+	return EvaluateNoiseLinear<true>(config, state, step);
 }
 
 // cubic interpolated noise
-float OscillatorNoiseCubic(OscillatorConfig const &config, OscillatorState &state, float step)
+static __forceinline float EvaluateNoiseCubic(OscillatorConfig const &config, OscillatorState &state, float step)
 {
 	return OscillatorCubic(config, state, noise, ARRAY_SIZE(noise), step);
 }
+float OscillatorNoiseCubic(OscillatorConfig const &config, OscillatorState &state, float step)
+{
+	if (step > 0.5f * ARRAY_SIZE(noise))
+		return 0;
+	return EvaluateNoiseCubic(config, state, step);
+}
+
+// sample-and-hold noise block renderer
+template <bool ANTIALIASED, bool SYNC> static void RenderNoiseHold(OscillatorConfig const &config, OscillatorState &state, float delta, float buffer[], size_t count)
+{
+	RenderWave<EvaluateNoiseHold<ANTIALIASED>, SYNC>(config, state, delta, GetNoiseHoldLimit<ANTIALIASED>(), buffer, count);
+}
+WaveRenderTable noise_hold_render =
+{
+	{ RenderNoiseHold<false, false>, RenderNoiseHold<false, true> },
+	{ RenderNoiseHold<true, false>, RenderNoiseHold<true, true> },
+	{ RenderNoiseHold<true, false>, RenderNoiseHold<true, true> },
+	{ RenderNoiseHold<true, false>, RenderNoiseHold<true, true> },
+};
+
+// linear interpolated noise block renderer
+template <bool ANTIALIASED, bool SYNC> static void RenderNoiseLinear(OscillatorConfig const &config, OscillatorState &state, float delta, float buffer[], size_t count)
+{
+	RenderWave<EvaluateNoiseLinear<ANTIALIASED>, SYNC>(config, state, delta, 0.5f * ARRAY_SIZE(noise), buffer, count);
+}
+WaveRenderTable noise_linear_render =
+{
+	{ RenderNoiseLinear<false, false>, RenderNoiseLinear<false, true> },
+	{ RenderNoiseLinear<true, false>, RenderNoiseLinear<true, true> },
+	{ RenderNoiseLinear<true, false>, RenderNoiseLinear<true, true> },
+	{ RenderNoiseLinear<true, false>, RenderNoiseLinear<true, true> },
+};
+
+// cubic interpolated noise block renderer
+// (cubic interpolation ignores antialiasing)
+template <bool SYNC> static void RenderNoiseCubic(OscillatorConfig const &config, OscillatorState &state, float delta, float buffer[], size_t count)
+{
+	RenderWave<EvaluateNoiseCubic, SYNC>(config, state, delta, 0.5f * ARRAY_SIZE(noise), buffer, count);
+}
+WaveRenderTable noise_cubic_render =
+{
+	{ RenderNoiseCubic<false>, RenderNoiseCubic<true> },
+	{ RenderNoiseCubic<false>, RenderNoiseCubic<true> },
+	{ RenderNoiseCubic<false>, RenderNoiseCubic<true> },
+	{ RenderNoiseCubic<false>, RenderNoiseCubic<true> },
+};
+
+// build the noise running sums
+void InitNoiseIntegrals()
+{
+	if (noise_sum2)
+		return;
+	int const length = ARRAY_SIZE(noise);
+	noise_sum2 = static_cast<double *>(malloc((length + 1) * sizeof(double)));
+	double sum = 0.0;
+	double sum2 = 0.0;
+	for (int i = 0; i < length; ++i)
+	{
+		noise_sum2[i] = sum2;
+		sum2 += sum + sum + noise[i];
+		sum += noise[i];
+	}
+	noise_sum2[length] = sum2;
+	noise_total = sum;
+}
@@ -1,12 +1,25 @@
 #pragma once
 
+#include "Wave.h"
+
+// noise wavetable length
+// (a power of two so positions split into periods with a shift)
+#define NOISE_LOG2_LENGTH 16
+#define NOISE_LENGTH (1 << NOISE_LOG2_LENGTH)
+
 // precomputed noise wavetable
-extern float noise[65536];
+// (in WaveData.cpp)
+extern float const noise[NOISE_LENGTH];
 
-// initialize noise wavetable
-extern void InitNoise();
+// build the running sums antialiased sample-and-hold noise uses at high pitch
+extern void InitNoiseIntegrals();
 
 // sample-and-hold noise
 extern float OscillatorNoiseHold(OscillatorConfig const &config, OscillatorState &state, float step);
 extern float OscillatorNoiseLinear(OscillatorConfig const &config, OscillatorState &state, float step);
 extern float OscillatorNoiseCubic(OscillatorConfig const &config, OscillatorState &state, float step);
+
+// sample-and-hold noise block renderers
+extern WaveRenderTable noise_hold_render;
+extern WaveRenderTable noise_linear_render;
+extern WaveRenderTable noise_cubic_render;
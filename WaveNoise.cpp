@@ -6,7 +6,6 @@ White Noise
 */
 #include "StdAfx.h"
 
-#include "Random.h"
 #include "WaveNoise.h"
 #include "Oscillator.h"
 #include "Math.h"
@@ -64,13 +63,12 @@ static float const w4 = w3 * falloff;
 static float const w5 = falloff - w1 - w2 - w3 - w4;
 #endif
 
-// noise wave
-float OscillatorNoise(OscillatorConfig const &config, OscillatorState &state, float step)
-{
-#if 1
-	// whte noise
-	float white = Random::Float() * 2.0f - 1.0f;
+// white noise samples generated at a time by the block renderer
+#define NOISE_BLOCK 64
 
+// colored noise from white noise
+static __forceinline float ColorNoise(OscillatorConfig const &config, OscillatorState &state, float const white)
+{
 	// if generating pure white noise, return that
 	if (config.waveparam == 0.5f)
 		return white;
@@ -149,7 +147,49 @@ float OscillatorNoise(OscillatorConfig const &config, OscillatorState &state, fl
 			return blue + (violet - blue) * s;
 		}
 	}
-#else
-	return Random::Float() * 2.0f - 1.0f;
-#endif
 }
+
+// noise wave
+static __forceinline float EvaluateNoise(OscillatorConfig const &config, OscillatorState &state, float step)
+{
+	// white noise from the oscillator's own random number stream
+	float const white = state.random.Float() * 2.0f - 1.0f;
+	return ColorNoise(config, state, white);
+}
+float OscillatorNoise(OscillatorConfig const &config, OscillatorState &state, float step)
+{
+	return EvaluateNoise(config, state, step);
+}
+
+// noise block renderer
+// (noise ignores antialiasing; white noise is generated a block at a time)
+template <bool SYNC> static void RenderNoise(OscillatorConfig const &config, OscillatorState &state, float delta, float buffer[], size_t count)
+{
+	// work on a local copy of the state
+	OscillatorState local(state);
+
+	// ramp amplitude across the block
+	float amplitude = config.amplitude_begin;
+	float const amplitude_step = (config.amplitude - config.amplitude_begin) / count;
+	float white[NOISE_BLOCK];
+	for (size_t begin = 0; begin < count; begin += NOISE_BLOCK)
+	{
+		size_t const n = Min(count - begin, size_t(NOISE_BLOCK));
+		local.random.Fill(white, n);
+		for (size_t i = 0; i < n; ++i)
+		{
+			amplitude += amplitude_step;
+			buffer[begin + i] += amplitude * ColorNoise(config, local, white[i] * 2.0f - 1.0f);
+			local.Advance<SYNC>(config, delta);
+		}
+	}
+
+	state = local;
+}
+WaveRenderTable noise_render =
+{
+	{ RenderNoise<false>, RenderNoise<true> },
+	{ RenderNoise<false>, RenderNoise<true> },
+	{ RenderNoise<false>, RenderNoise<true> },
+	{ RenderNoise<false>, RenderNoise<true> },
+};
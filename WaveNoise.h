@@ -6,7 +6,12 @@ Copyright 2014 Kenneth D. Miller III
 White Noise
 */
 
+#include "Wave.h"
+
 class OscillatorConfig;
 class OscillatorState;
 
 float OscillatorNoise(OscillatorConfig const &config, OscillatorState &state, float step);
+
+// noise block renderers
+extern WaveRenderTable noise_render;
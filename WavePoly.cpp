@@ -12,19 +12,7 @@ Poly-Noise Wave
 #include "PolyBLEP.h"
 #include "Math.h"
 
-// precomputed linear feedback shift register output
-char poly4[(1 << 4) - 1];
-char poly5[(1 << 5) - 1];
-char period93[93];
-char poly9[(1 << 9) - 1];
-char poly17[(1 << 17) - 1];
-
-// precomputed wave tables for poly5-clocked waveforms
-char pulsepoly5[ARRAY_SIZE(poly5) * 2];
-char poly4poly5[ARRAY_SIZE(poly5) * ARRAY_SIZE(poly4)];
-char poly17poly5[ARRAY_SIZE(poly5) * ARRAY_SIZE(poly17)];
-
-static char const * const poly_data[WAVE_COUNT] =
+static unsigned int const * const poly_data[WAVE_COUNT] =
 {
 	NULL,			// WAVE_SINE,
 	NULL,			// WAVE_PULSE,
@@ -41,128 +29,305 @@ static char const * const poly_data[WAVE_COUNT] =
 	poly17,			// WAVE_POLY17,
 	pulsepoly5,		// WAVE_PULSE_POLY5,
 	poly4poly5,		// WAVE_POLY4_POLY5,
-	poly17poly5,	// WAVE_POLY17_POLY5,
+	NULL,			// WAVE_POLY17_POLY5,
 };
 
-// generate polynomial table
-// from Atari800 pokey.c
-static void InitPoly(char aOut[], int aSize, int aTap, unsigned int aSeed, char aInvert)
+// running sums at the start of each word of a packed poly table
+// (sum2 is twice the running sum of running sums, which keeps it an integer;
+// the entry after the last word holds the sums over the full period)
+struct PolySum
 {
-	unsigned int x = aSeed;
-	unsigned int i = 0;
-	do
-	{
-		aOut[i] = (x & 1) ^ aInvert;
-		x = ((((x >> aTap) ^ x) & 1) << (aSize - 1)) | (x >> 1);
-		++i;
-	}
-	while (x != aSeed);
+	double sum;
+	double sum2;
+};
+static PolySum poly4_sum[POLY_WORDS(POLY4_LENGTH)];
+static PolySum poly5_sum[POLY_WORDS(POLY5_LENGTH)];
+static PolySum period93_sum[POLY_WORDS(PERIOD93_LENGTH)];
+static PolySum poly9_sum[POLY_WORDS(POLY9_LENGTH)];
+static PolySum poly17_sum[POLY_WORDS(POLY17_LENGTH)];
+static PolySum pulsepoly5_sum[POLY_WORDS(PULSE_POLY5_LENGTH)];
+static PolySum poly4poly5_sum[POLY_WORDS(POLY4_POLY5_LENGTH)];
+
+static PolySum * const poly_sum[WAVE_COUNT] =
+{
+	NULL,			// WAVE_SINE,
+	NULL,			// WAVE_PULSE,
+	NULL,			// WAVE_SAWTOOTH,
+	NULL,			// WAVE_TRIANGLE,
+	NULL,			// WAVE_NOISE,
+	NULL,			// WAVE_NOISE_HOLD,
+	NULL,			// WAVE_NOISE_LINEAR,
+	NULL,			// WAVE_NOISE_CUBIC,
+	poly4_sum,		// WAVE_POLY4,
+	poly5_sum,		// WAVE_POLY5,
+	period93_sum,	// WAVE_PERIOD93,
+	poly9_sum,		// WAVE_POLY9,
+	poly17_sum,		// WAVE_POLY17,
+	pulsepoly5_sum,	// WAVE_PULSE_POLY5,
+	poly4poly5_sum,	// WAVE_POLY4_POLY5,
+	NULL,			// WAVE_POLY17_POLY5,
+};
+
+// set bits in each byte of a word (low half) and the sum of their positions
+// within the word (high half)
+static unsigned int poly_byte_sum[4][256];
+
+// PolyBLEP window half-width above which poly waves use their running sums
+// (Poly17/Poly5 is too long to keep sums for and always walks its steps)
+#define POLY_INTEGRAL_WIDTH 4.0f
+
+// get 32 samples from a packed table starting at the index
+// (bit 0 of the result is the sample at the index)
+static __forceinline unsigned int GetPolyWindow(unsigned int const bits[], int const index)
+{
+	int const word = index >> 5;
+	return (unsigned int)(((unsigned long long)(bits[word + 1]) << 32 | bits[word]) >> (index & 31));
 }
 
-// generate pulsepoly5 table
-static void InitPulsePoly5()
+// get a sample of poly17poly5
+static __forceinline int GetPoly17Poly5Sample(int const index)
 {
-	char output = 0;
-	int index5 = 0;
-	for (int i = 0; i < ARRAY_SIZE(pulsepoly5); ++i)
-	{
-		if (poly5[index5])
-			output = !output;
-		pulsepoly5[i] = output;
-		if (++index5 == ARRAY_SIZE(poly5))
-			index5 = 0;
-	}
+	int const held = index - poly5_back[index % POLY5_LENGTH];
+	return held >= 0 ? GetPolyBit(poly17, (held + 1) % POLY17_LENGTH) : 0;
 }
 
-// generate poly4poly5 table
-static void InitPoly4Poly5()
+// get count + 1 samples of poly17poly5 starting at the index
+// (count must be less than 32)
+// (poly5 clocks a new poly17 sample into the output when its output is 1 and
+// the output holds its value otherwise; the output restarts low at the start
+// of each loop, as in the original precomputed table)
+static __forceinline unsigned int GetPoly17Poly5Window(int const index, int const count)
 {
-	char output = 0;
-	int index5 = 0;
-	int index4 = 0;
-	for (int i = 0; i < ARRAY_SIZE(poly4poly5); ++i)
+	int const index5 = index % POLY5_LENGTH;
+	int const index17 = (index + 1) % POLY17_LENGTH;
+
+	// output held from the last clock before the window
+	int const back = poly5_back[index5];
+	int held17 = index17 - back;
+	if (held17 < 0)
+		held17 += POLY17_LENGTH;
+	int const held = index >= back ? GetPolyBit(poly17, held17) : 0;
+
+	// clock and poly17 samples for the window
+	unsigned int clock = GetPolyWindow(poly5, index5);
+	unsigned int value = GetPolyWindow(poly17, index17) & clock;
+
+	// the loop restart acts as a clock of a low sample
+	int const restart = POLY17_POLY5_LENGTH - index;
+	if (restart <= count)
 	{
-		if (++index4 == ARRAY_SIZE(poly4))
-			index4 = 0;
-		if (poly5[index5])
-			output = poly4[index4];
-		poly4poly5[i] = output;
-		if (++index5 == ARRAY_SIZE(poly5))
-			index5 = 0;
+		clock |= 1U << restart;
+		value &= ~(1U << restart);
 	}
+
+	// fill each unclocked sample from the nearest clocked sample before it
+	for (int shift = 1; shift <= count; shift += shift)
+	{
+		value |= (value << shift) & ~clock;
+		clock |= clock << shift;
+	}
+
+	// samples before the first clock hold the output from before the window
+	if (held)
+		value |= ~clock;
+	return value;
+}
+
+// get a sample of a poly waveform
+static __forceinline int GetPolySample(Wave const wavetype, int const index)
+{
+	if (wavetype == WAVE_POLY17_POLY5)
+		return GetPoly17Poly5Sample(index);
+	return GetPolyBit(poly_data[wavetype], index);
 }
 
-// generate poly17poly5 table
-static void InitPoly17Poly5()
+// get count + 1 samples of a poly waveform starting at the index
+// (count must be less than 32; higher bits of the result are unspecified)
+static __forceinline unsigned int GetPolySamples(Wave const wavetype, int const index, int const count)
 {
-	char output = 0;
-	int index5 = 0;
-	int index17 = 0;
-	for (int i = 0; i < ARRAY_SIZE(poly17poly5); ++i)
+	if (wavetype == WAVE_POLY17_POLY5)
+		return GetPoly17Poly5Window(index, count);
+	return GetPolyWindow(poly_data[wavetype], index);
+}
+
+// twice the second integral of a poly waveform at the index plus an offset
+static __forceinline double IntegratePoly(Wave const wavetype, int const index, double const offset)
+{
+	unsigned int const *bits = poly_data[wavetype];
+	PolySum const *sums = poly_sum[wavetype];
+	int const length = wave_loop_cycle[wavetype];
+
+	// split the position into periods, samples, and a fraction
+	int advance = int(offset);
+	if (advance > offset)
+		--advance;
+	double const f = offset - advance;
+	int r = index + advance;
+	int q = 0;
+	if (r < 0 || r >= length)
 	{
-		if (++index17 == ARRAY_SIZE(poly17))
-			index17 = 0;
-		if (poly5[index5])
-			output = poly17[index17];
-		poly17poly5[i] = output;
-		if (++index5 == ARRAY_SIZE(poly5))
-			index5 = 0;
+		q = r / length;
+		r -= q * length;
+		if (r < 0)
+		{
+			r += length;
+			--q;
+		}
 	}
+
+	// running sums from the start of the word up to the sample
+	// (a set bit at position i adds one to sum2 for itself and two for each of
+	// the bit - 1 - i samples after it)
+	int const word = r >> 5;
+	int const bit = r & 31;
+	unsigned int const before = bits[word] & ((1U << bit) - 1);
+	unsigned int const bytes =
+		poly_byte_sum[0][before & 0xFF] +
+		poly_byte_sum[1][(before >> 8) & 0xFF] +
+		poly_byte_sum[2][(before >> 16) & 0xFF] +
+		poly_byte_sum[3][before >> 24];
+	int const count = int(bytes & 0xFFFF);
+	int const position = int(bytes >> 16);
+	double const sum = sums[word].sum + count;
+	double const sum2 = sums[word].sum2 + 2.0 * bit * sums[word].sum + double(2 * (bit - 1) * count - 2 * position + count);
+
+	PolySum const &total = sums[(length + 31) >> 5];
+	return HeldIntegral(q, r, f, sum, sum2, float((bits[word] >> bit) & 1), length, total.sum, total.sum2);
 }
 
-// initialize polynomial noise tables
-void InitPoly()
-{
-	InitPoly(poly4, 4, 1, 0xF, 0);
-	InitPoly(poly5, 5, 2, 0x1F, 1);
-	InitPoly(period93, 15, 6, 0x7FFF, 0);
-	InitPoly(poly9, 9, 4, 0x1FF, 0);
-	InitPoly(poly17, 17, 5, 0x1FFFF, 0);
-	InitPulsePoly5();
-	InitPoly4Poly5();
-	InitPoly17Poly5();
+// highest phase step a poly waveform can represent
+// (with running sums, the filtered wave settles to its average at high steps
+// instead of aliasing; other poly waves fall silent above half the period)
+template <bool ANTIALIASED> static __forceinline float GetPolyLimit(Wave const wavetype)
+{
+#if ANTIALIAS == ANTIALIAS_POLYBLEP
+	if (ANTIALIASED && poly_sum[wavetype])
+		return FLT_MAX;
+#endif
+	return 0.5f * wave_loop_cycle[wavetype];
 }
 
 // shared poly oscillator
-float OscillatorPoly(OscillatorConfig const &config, OscillatorState &state, float step)
+template <bool ANTIALIASED> static __forceinline float EvaluatePoly(OscillatorConfig const &config, OscillatorState &state, float step)
 {
 	// poly info for the wave type
 	int const cycle = wave_loop_cycle[config.wavetype];
-	if (step > 0.5f * cycle)
-		return 0;
-
-	// current wavetable value
-	char const * const poly = poly_data[config.wavetype];
-	float value = poly[state.index];
 
 #if ANTIALIAS == ANTIALIAS_POLYBLEP
-	if (use_antialias)
+	if (ANTIALIASED)
 	{
-		float w = Min(step * POLYBLEP_WIDTH, 8.0f);
+		float w = step * POLYBLEP_WIDTH;
+		if (w > POLY_INTEGRAL_WIDTH && poly_sum[config.wavetype])
+		{
+			// filter through the running sums
+			double const phase = state.phase;
+			double const before = IntegratePoly(config.wavetype, state.index, phase - w);
+			double const at = IntegratePoly(config.wavetype, state.index, phase);
+			double const after = IntegratePoly(config.wavetype, state.index, phase + w);
+			float const value = HeldFilter(before, at, after, w);
+			return value + value - 1.0f;
+		}
+		w = Min(w, 8.0f);
 
 		int const back = FloorInt(state.phase - w);
 		int const ahead = FloorInt(state.phase + w);
 		int const count = ahead - back;
 		if (count > 0)
 		{
-			int i = state.index + back + cycle;
-			if (i >= cycle)
-				i -= cycle;
-			float t = state.phase - back;
-			char v0 = poly[i];
-			for (int c = 0; c < count; ++c)
+			// samples from the furthest back to the furthest ahead
+			int first = state.index + back;
+			if (first < 0)
+				first += cycle;
+			unsigned int const samples = GetPolySamples(config.wavetype, first, count);
+
+			// current wavetable value
+			float value = float((samples >> -back) & 1);
+
+			// transitions between neighboring samples
+			unsigned int edges = (samples ^ (samples >> 1)) & ((1U << count) - 1);
+			while (edges)
 			{
-				if (++i >= cycle)
-					i -= cycle;
-				t -= 1.0f;
-				char v1 = poly[i];
-				if (v0 != v1)
-					value += PolyBLEP(t, w, float(v1 - v0));
-				v0 = v1;
+				int const c = CountTrailingZeros(edges);
+				edges &= edges - 1;
+				float const t = state.phase - float(back + c + 1);
+				value += PolyBLEP(t, w, ((samples >> (c + 1)) & 1) ? 1.0f : -1.0f);
 			}
+
+			return value + value - 1.0f;
 		}
 	}
 #endif
 
+	// current wavetable value
+	float const value = float(GetPolySample(config.wavetype, state.index));
 	return value + value - 1.0f;
 }
+
+float OscillatorPoly(OscillatorConfig const &config, OscillatorState &state, float step)
+{
+	if (!use_antialias)
+	{
+		if (step > GetPolyLimit<false>(config.wavetype))
+			return 0;
+		return EvaluatePoly<false>(config, state, step);
+	}
+	if (step > GetPolyLimit<true>(config.wavetype))
+		return 0;
+	return EvaluatePoly<true>(config, state, step);
+}
+
+// poly block renderer
+template <bool ANTIALIASED, bool SYNC> static void RenderPoly(OscillatorConfig const &config, OscillatorState &state, float delta, float buffer[], size_t count)
+{
+	RenderWave<EvaluatePoly<ANTIALIASED>, SYNC>(config, state, delta, GetPolyLimit<ANTIALIASED>(config.wavetype), buffer, count);
+}
+WaveRenderTable poly_render =
+{
+	{ RenderPoly<false, false>, RenderPoly<false, true> },
+	{ RenderPoly<true, false>, RenderPoly<true, true> },
+	{ RenderPoly<true, false>, RenderPoly<true, true> },
+	{ RenderPoly<true, false>, RenderPoly<true, true> },
+};
+
+// build the running sums for a packed poly table
+static void BuildPolySum(PolySum sums[], unsigned int const bits[], int const length)
+{
+	double sum = 0.0;
+	double sum2 = 0.0;
+	for (int i = 0; i < length; ++i)
+	{
+		if (!(i & 31))
+		{
+			sums[i >> 5].sum = sum;
+			sums[i >> 5].sum2 = sum2;
+		}
+		int const value = GetPolyBit(bits, i);
+		sum2 += sum + sum + value;
+		sum += value;
+	}
+	sums[(length + 31) >> 5].sum = sum;
+	sums[(length + 31) >> 5].sum2 = sum2;
+}
+
+// build the poly running sums
+void InitPolyIntegrals()
+{
+	for (int b = 0; b < 4; ++b)
+	{
+		for (int value = 0; value < 256; ++value)
+		{
+			unsigned int sum = 0;
+			for (int i = 0; i < 8; ++i)
+			{
+				if (value & (1 << i))
+					sum += 1 + ((b * 8 + i) << 16);
+			}
+			poly_byte_sum[b][value] = sum;
+		}
+	}
+	for (int wavetype = 0; wavetype < WAVE_COUNT; ++wavetype)
+	{
+		if (poly_sum[wavetype])
+			BuildPolySum(poly_sum[wavetype], poly_data[wavetype], wave_loop_cycle[wavetype]);
+	}
+}
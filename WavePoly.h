@@ -6,23 +6,58 @@ Copyright 2014 Kenneth D. Miller III
 Poly-Noise Wave
 */
 
+#include "Wave.h"
+
 class OscillatorConfig;
 class OscillatorState;
 
-// precomputed linear feedback shift register output
-extern char poly4[(1 << 4) - 1];
-extern char poly5[(1 << 5) - 1];
-extern char period93[93];
-extern char poly9[(1 << 9) - 1];
-extern char poly17[(1 << 17) - 1];
+// linear feedback shift register periods
+#define POLY4_LENGTH ((1 << 4) - 1)
+#define POLY5_LENGTH ((1 << 5) - 1)
+#define PERIOD93_LENGTH 93
+#define POLY9_LENGTH ((1 << 9) - 1)
+#define POLY17_LENGTH ((1 << 17) - 1)
+
+// poly5-clocked waveform periods
+#define PULSE_POLY5_LENGTH (POLY5_LENGTH * 2)
+#define POLY4_POLY5_LENGTH (POLY5_LENGTH * POLY4_LENGTH)
+#define POLY17_POLY5_LENGTH (POLY5_LENGTH * POLY17_LENGTH)
+
+// The poly tables are stored one bit per sample, 32 samples to a word, and
+// each one repeats its own start for at least 32 samples past its end so a
+// 32-sample window can be read from any index without wrapping.  Poly17/Poly5
+// would take 4 million samples, so it is generated from poly5 and poly17 as
+// needed instead.  The tables are precomputed in WaveData.cpp.
+
+// words for a packed table of the given length
+#define POLY_WORDS(length) (((length) + 63) / 32)
 
-// precomputed wave tables for poly5-clocked waveforms
-extern char pulsepoly5[ARRAY_SIZE(poly5) * 2];
-extern char poly4poly5[ARRAY_SIZE(poly5) * ARRAY_SIZE(poly4)];
-extern char poly17poly5[ARRAY_SIZE(poly5) * ARRAY_SIZE(poly17)];
+// packed linear feedback shift register output
+extern unsigned int const poly4[POLY_WORDS(POLY4_LENGTH)];
+extern unsigned int const poly5[POLY_WORDS(POLY5_LENGTH)];
+extern unsigned int const period93[POLY_WORDS(PERIOD93_LENGTH)];
+extern unsigned int const poly9[POLY_WORDS(POLY9_LENGTH)];
+extern unsigned int const poly17[POLY_WORDS(POLY17_LENGTH)];
 
-// initialize polynomial noise tables
-extern void InitPoly();
+// packed wave tables for short poly5-clocked waveforms
+extern unsigned int const pulsepoly5[POLY_WORDS(PULSE_POLY5_LENGTH)];
+extern unsigned int const poly4poly5[POLY_WORDS(POLY4_POLY5_LENGTH)];
+
+// samples since the last poly5 clock at each poly5 index
+// (poly5 clocks the poly5-clocked waveforms when its output is 1)
+extern unsigned char const poly5_back[POLY5_LENGTH];
+
+// get a sample from a packed table
+static __forceinline int GetPolyBit(unsigned int const bits[], int const index)
+{
+	return (bits[index >> 5] >> (index & 31)) & 1;
+}
+
+// build the running sums the antialiased poly waves use at high pitch
+extern void InitPolyIntegrals();
 
 // poly waveform
 extern float OscillatorPoly(OscillatorConfig const &config, OscillatorState &state, float step);
+
+// poly block renderers
+extern WaveRenderTable poly_render;
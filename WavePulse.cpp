@@ -10,6 +10,7 @@ Pulse Wave
 #include "WavePulse.h"
 #include "Oscillator.h"
 #include "PolyBLEP.h"
+#include "Wavetable.h"
 #include "Math.h"
 
 // pulse waveform
@@ -21,10 +22,8 @@ static __forceinline float GetPulseValue(float const phase, float const width)
 {
 	return phase < width ? 1.0f : -1.0f;
 }
-float OscillatorPulse(OscillatorConfig const &config, OscillatorState &state, float step)
+template <bool ANTIALIASED, bool SYNC> static __forceinline float EvaluatePulse(OscillatorConfig const &config, OscillatorState &state, float step)
 {
-	if (step > 0.5f)
-		return 0.0f;
 	if (config.waveparam <= 0.0f)
 		return -1.0f;
 	if (config.waveparam >= 1.0f)
@@ -32,7 +31,7 @@ float OscillatorPulse(OscillatorConfig const &config, OscillatorState &state, fl
 	float const phase = state.phase;
 	float value = GetPulseValue(phase, config.waveparam);
 #if ANTIALIAS == ANTIALIAS_POLYBLEP
-	if (use_antialias)
+	if (ANTIALIASED)
 	{
 		float const w = Min(step * POLYBLEP_WIDTH, 0.5f);
 
@@ -42,7 +41,7 @@ float OscillatorPulse(OscillatorConfig const &config, OscillatorState &state, fl
 		// nearest down edge
 		float const down_nearest = float(phase - 0.5f >= config.waveparam) - float(phase + 0.5f < config.waveparam) + config.waveparam;
 
-		if (config.sync_enable)
+		if (SYNC)
 		{
 			// short-circuit case
 			if (config.sync_phase < config.waveparam)
@@ -96,3 +95,84 @@ float OscillatorPulse(OscillatorConfig const &config, OscillatorState &state, fl
 #endif
 	return value;
 }
+float OscillatorPulse(OscillatorConfig const &config, OscillatorState &state, float step)
+{
+	if (step > 0.5f)
+		return 0.0f;
+	if (!use_antialias)
+		return EvaluatePulse<false, false>(config, state, step);
+	if (!config.sync_enable)
+		return EvaluatePulse<true, false>(config, state, step);
+	return EvaluatePulse<true, true>(config, state, step);
+}
+
+// pulse block renderer
+template <bool ANTIALIASED, bool SYNC> static void RenderPulse(OscillatorConfig const &config, OscillatorState &state, float delta, float buffer[], size_t count)
+{
+	RenderWave<EvaluatePulse<ANTIALIASED, SYNC>, SYNC>(config, state, delta, 0.5f, buffer, count);
+}
+
+// pulse minBLEP value
+// (the naive wave is flat, so no delay offset)
+static __forceinline float EvaluatePulseMinBLEP(OscillatorConfig const &config, OscillatorState &state, float delta)
+{
+	if (config.waveparam <= 0.0f)
+		return -1.0f;
+	if (config.waveparam >= 1.0f)
+		return 1.0f;
+	return GetPulseValue(state.phase, config.waveparam);
+}
+
+// pulse minBLEP corrections
+static __forceinline void CorrectPulseMinBLEP(OscillatorConfig const &config, OscillatorState &state, float phase, float delta)
+{
+	if (config.waveparam <= 0.0f || config.waveparam >= 1.0f)
+		return;
+
+	// down edge at the pulse width
+	// (before or after the phase wrap)
+	float const end = phase + delta;
+	if (phase < config.waveparam && end >= config.waveparam)
+		state.AddStep((end - config.waveparam) / delta, -2.0f);
+	else if (end >= 1.0f + config.waveparam)
+		state.AddStep((end - 1.0f - config.waveparam) / delta, -2.0f);
+
+	// up edge at the phase wrap
+	if (end >= 1.0f)
+		state.AddStep((end - 1.0f) / delta, 2.0f);
+}
+
+// pulse minBLEP block renderer
+static void RenderPulseMinBLEP(OscillatorConfig const &config, OscillatorState &state, float delta, float buffer[], size_t count)
+{
+	RenderWaveMinBLEP<EvaluatePulseMinBLEP, CorrectPulseMinBLEP>(config, state, delta, 0.5f, buffer, count);
+}
+
+// pulse wavetable value
+// (difference of two sawtooth waves offset by the pulse width)
+static __forceinline float EvaluatePulseWavetable(OscillatorConfig const &config, WavetableLevels const &levels, float phase)
+{
+	float const width = config.waveparam;
+	if (width <= 0.0f)
+		return -1.0f;
+	if (width >= 1.0f)
+		return 1.0f;
+	float offset = phase - width;
+	if (offset < 0.0f)
+		offset += 1.0f;
+	return LookupWavetable(levels, phase) - LookupWavetable(levels, offset) + 2 * width - 1;
+}
+
+// pulse wavetable block renderer
+static void RenderPulseWavetable(OscillatorConfig const &config, OscillatorState &state, float delta, float buffer[], size_t count)
+{
+	RenderWavetable<EvaluatePulseWavetable>(config, state, *wavetable_sawtooth, delta, 0.5f, buffer, count);
+}
+
+WaveRenderTable pulse_render =
+{
+	{ RenderPulse<false, false>, RenderPulse<false, true> },
+	{ RenderPulse<true, false>, RenderPulse<true, true> },
+	{ RenderPulseMinBLEP, RenderPulse<true, true> },
+	{ RenderPulseWavetable, RenderPulse<true, true> },
+};
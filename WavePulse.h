@@ -6,7 +6,12 @@ Copyright 2014 Kenneth D. Miller III
 Pulse Wave
 */
 
+#include "Wave.h"
+
 class OscillatorConfig;
 class OscillatorState;
 
 extern float OscillatorPulse(OscillatorConfig const &config, OscillatorState &state, float step);
+
+// pulse block renderers
+extern WaveRenderTable pulse_render;
@@ -7,8 +7,10 @@ Sawtooth Wave
 #include "StdAfx.h"
 
 #include "Wave.h"
+#include "WaveSawtooth.h"
 #include "Oscillator.h"
 #include "PolyBLEP.h"
+#include "Wavetable.h"
 #include "Math.h"
 
 // sawtooth wave
@@ -18,22 +20,20 @@ static __forceinline float GetSawtoothValue(float const phase)
 {
 	return 1 - phase - phase;
 }
-float OscillatorSawtooth(OscillatorConfig const &config, OscillatorState &state, float step)
+template <bool ANTIALIASED, bool SYNC> static __forceinline float EvaluateSawtooth(OscillatorConfig const &config, OscillatorState &state, float step)
 {
-	if (step > 0.5f)
-		return 0.0f;
 	float phase = state.phase;
 	float value = GetSawtoothValue(phase);
 
 #if ANTIALIAS == ANTIALIAS_POLYBLEP
-	if (use_antialias)
+	if (ANTIALIASED)
 	{
 		float const w = Min(step * POLYBLEP_WIDTH, 0.5f);
 
 		// up edge nearest the current phase
 		float up_nearest = float(phase >= 0.5f);
 
-		if (config.sync_enable)
+		if (SYNC)
 		{
 			int const index = state.index;
 			phase += index;
@@ -64,3 +64,60 @@ float OscillatorSawtooth(OscillatorConfig const &config, OscillatorState &state,
 #endif
 	return value;
 }
+float OscillatorSawtooth(OscillatorConfig const &config, OscillatorState &state, float step)
+{
+	if (step > 0.5f)
+		return 0.0f;
+	if (!use_antialias)
+		return EvaluateSawtooth<false, false>(config, state, step);
+	if (!config.sync_enable)
+		return EvaluateSawtooth<true, false>(config, state, step);
+	return EvaluateSawtooth<true, true>(config, state, step);
+}
+
+// sawtooth block renderer
+template <bool ANTIALIASED, bool SYNC> static void RenderSawtooth(OscillatorConfig const &config, OscillatorState &state, float delta, float buffer[], size_t count)
+{
+	RenderWave<EvaluateSawtooth<ANTIALIASED, SYNC>, SYNC>(config, state, delta, 0.5f, buffer, count);
+}
+
+// sawtooth minBLEP value
+// (the naive ramp falls by 2 * delta per sample)
+static __forceinline float EvaluateSawtoothMinBLEP(OscillatorConfig const &config, OscillatorState &state, float delta)
+{
+	return GetSawtoothValue(state.phase) + 2 * delta * minblep_delay;
+}
+
+// sawtooth minBLEP corrections
+static __forceinline void CorrectSawtoothMinBLEP(OscillatorConfig const &config, OscillatorState &state, float phase, float delta)
+{
+	// up edge at the phase wrap
+	if (state.phase < delta)
+		state.AddStep(state.phase / delta, 2.0f);
+}
+
+// sawtooth minBLEP block renderer
+static void RenderSawtoothMinBLEP(OscillatorConfig const &config, OscillatorState &state, float delta, float buffer[], size_t count)
+{
+	RenderWaveMinBLEP<EvaluateSawtoothMinBLEP, CorrectSawtoothMinBLEP>(config, state, delta, 0.5f, buffer, count);
+}
+
+// sawtooth wavetable value
+static __forceinline float EvaluateSawtoothWavetable(OscillatorConfig const &config, WavetableLevels const &levels, float phase)
+{
+	return LookupWavetable(levels, phase);
+}
+
+// sawtooth wavetable block renderer
+static void RenderSawtoothWavetable(OscillatorConfig const &config, OscillatorState &state, float delta, float buffer[], size_t count)
+{
+	RenderWavetable<EvaluateSawtoothWavetable>(config, state, *wavetable_sawtooth, delta, 0.5f, buffer, count);
+}
+
+WaveRenderTable sawtooth_render =
+{
+	{ RenderSawtooth<false, false>, RenderSawtooth<false, true> },
+	{ RenderSawtooth<true, false>, RenderSawtooth<true, true> },
+	{ RenderSawtoothMinBLEP, RenderSawtooth<true, true> },
+	{ RenderSawtoothWavetable, RenderSawtooth<true, true> },
+};
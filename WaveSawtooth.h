@@ -6,7 +6,12 @@ Copyright 2014 Kenneth D. Miller III
 Sawtooth Wave
 */
 
+#include "Wave.h"
+
 class OscillatorConfig;
 class OscillatorState;
 
 extern float OscillatorSawtooth(OscillatorConfig const &config, OscillatorState &state, float step);
+
+// sawtooth block renderers
+extern WaveRenderTable sawtooth_render;
@@ -7,6 +7,7 @@ Sine Wave
 #include "StdAfx.h"
 
 #include "Wave.h"
+#include "WaveSine.h"
 #include "Oscillator.h"
 #include "PolyBLEP.h"
 #include "Math.h"
@@ -23,14 +24,12 @@ static __forceinline float GetSineSlope(float const phase)
 {
 	return 2 * M_PI * cosf(M_PI * 2 * phase);
 }
-float OscillatorSine(OscillatorConfig const &config, OscillatorState &state, float step)
+template <bool ANTIALIASED, bool SYNC> static __forceinline float EvaluateSine(OscillatorConfig const &config, OscillatorState &state, float step)
 {
-	if (step > 0.5f)
-		return 0.0f;
 	float phase = state.phase;
 	float value = GetSineValue(phase);
 #if ANTIALIAS == ANTIALIAS_POLYBLEP
-	if (use_antialias && config.sync_enable)
+	if (ANTIALIASED && SYNC)
 	{
 		int const index = state.index;
 		phase += index;
@@ -54,4 +53,27 @@ float OscillatorSine(OscillatorConfig const &config, OscillatorState &state, flo
 #endif
 	return value;
 }
+float OscillatorSine(OscillatorConfig const &config, OscillatorState &state, float step)
+{
+	if (step > 0.5f)
+		return 0.0f;
+	if (!use_antialias)
+		return EvaluateSine<false, false>(config, state, step);
+	if (!config.sync_enable)
+		return EvaluateSine<true, false>(config, state, step);
+	return EvaluateSine<true, true>(config, state, step);
+}
+
+// sine block renderer
+template <bool ANTIALIASED, bool SYNC> static void RenderSine(OscillatorConfig const &config, OscillatorState &state, float delta, float buffer[], size_t count)
+{
+	RenderWave<EvaluateSine<ANTIALIASED, SYNC>, SYNC>(config, state, delta, 0.5f, buffer, count);
+}
+WaveRenderTable sine_render =
+{
+	{ RenderSine<false, false>, RenderSine<false, true> },
+	{ RenderSine<true, false>, RenderSine<true, true> },
+	{ RenderSine<true, false>, RenderSine<true, true> },
+	{ RenderSine<true, false>, RenderSine<true, true> },
+};
 
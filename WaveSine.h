@@ -6,8 +6,13 @@ Copyright 2014 Kenneth D. Miller III
 Sine Wave
 */
 
+#include "Wave.h"
+
 class OscillatorConfig;
 class OscillatorState;
 
 // sine wave
 float OscillatorSine(OscillatorConfig const &config, OscillatorState &state, float step);
+
+// sine block renderers
+extern WaveRenderTable sine_render;
@@ -7,8 +7,10 @@ Triangle Wave
 #include "StdAfx.h"
 
 #include "Wave.h"
+#include "WaveTriangle.h"
 #include "Oscillator.h"
 #include "PolyBLEP.h"
+#include "Wavetable.h"
 #include "Math.h"
 
 // triangle oscillator
@@ -17,13 +19,11 @@ static __forceinline float GetTriangleValue(float const phase)
 {
 	return fabsf(4 * (phase - FloorInt(phase - 0.25f)) - 3) - 1;
 }
-float OscillatorTriangle(OscillatorConfig const &config, OscillatorState &state, float step)
+template <bool ANTIALIASED, bool SYNC> static __forceinline float EvaluateTriangle(OscillatorConfig const &config, OscillatorState &state, float step)
 {
-	if (step > 0.5f)
-		return 0.0f;
 	float value = GetTriangleValue(state.phase);
 #if ANTIALIAS == ANTIALIAS_POLYBLEP
-	if (use_antialias)
+	if (ANTIALIASED)
 	{
 		float phase = state.phase;
 
@@ -35,7 +35,7 @@ float OscillatorTriangle(OscillatorConfig const &config, OscillatorState &state,
 		// nearest \/ slope transition
 		float up_nearest = float(phase >= 0.25f) - 0.25f;
 
-		if (config.sync_enable)
+		if (SYNC)
 		{
 			int const index = state.index;
 			phase += index;
@@ -84,3 +84,69 @@ float OscillatorTriangle(OscillatorConfig const &config, OscillatorState &state,
 #endif
 	return value;
 }
+float OscillatorTriangle(OscillatorConfig const &config, OscillatorState &state, float step)
+{
+	if (step > 0.5f)
+		return 0.0f;
+	if (!use_antialias)
+		return EvaluateTriangle<false, false>(config, state, step);
+	if (!config.sync_enable)
+		return EvaluateTriangle<true, false>(config, state, step);
+	return EvaluateTriangle<true, true>(config, state, step);
+}
+
+// triangle block renderer
+template <bool ANTIALIASED, bool SYNC> static void RenderTriangle(OscillatorConfig const &config, OscillatorState &state, float delta, float buffer[], size_t count)
+{
+	RenderWave<EvaluateTriangle<ANTIALIASED, SYNC>, SYNC>(config, state, delta, 0.5f, buffer, count);
+}
+
+// triangle minBLEP value
+// (the naive wave rises or falls by 4 * delta per sample)
+static __forceinline float EvaluateTriangleMinBLEP(OscillatorConfig const &config, OscillatorState &state, float delta)
+{
+	float const phase = state.phase;
+	float const slope = (phase >= 0.25f && phase < 0.75f) ? -4 * delta : 4 * delta;
+	return GetTriangleValue(phase) - slope * minblep_delay;
+}
+
+// triangle minBLEP corrections
+static __forceinline void CorrectTriangleMinBLEP(OscillatorConfig const &config, OscillatorState &state, float phase, float delta)
+{
+	// /\ slope transitions (before or after the phase wrap)
+	float const end = phase + delta;
+	if (phase < 0.25f && end >= 0.25f)
+		state.AddRamp((end - 0.25f) / delta, -8 * delta);
+	else if (end >= 1.25f)
+		state.AddRamp((end - 1.25f) / delta, -8 * delta);
+
+	// \/ slope transition
+	if (phase < 0.75f && end >= 0.75f)
+		state.AddRamp((end - 0.75f) / delta, 8 * delta);
+}
+
+// triangle minBLEP block renderer
+static void RenderTriangleMinBLEP(OscillatorConfig const &config, OscillatorState &state, float delta, float buffer[], size_t count)
+{
+	RenderWaveMinBLEP<EvaluateTriangleMinBLEP, CorrectTriangleMinBLEP>(config, state, delta, 0.5f, buffer, count);
+}
+
+// triangle wavetable value
+static __forceinline float EvaluateTriangleWavetable(OscillatorConfig const &config, WavetableLevels const &levels, float phase)
+{
+	return LookupWavetable(levels, phase);
+}
+
+// triangle wavetable block renderer
+static void RenderTriangleWavetable(OscillatorConfig const &config, OscillatorState &state, float delta, float buffer[], size_t count)
+{
+	RenderWavetable<EvaluateTriangleWavetable>(config, state, *wavetable_triangle, delta, 0.5f, buffer, count);
+}
+
+WaveRenderTable triangle_render =
+{
+	{ RenderTriangle<false, false>, RenderTriangle<false, true> },
+	{ RenderTriangle<true, false>, RenderTriangle<true, true> },
+	{ RenderTriangleMinBLEP, RenderTriangle<true, true> },
+	{ RenderTriangleWavetable, RenderTriangle<true, true> },
+};
@@ -6,7 +6,12 @@ Copyright 2014 Kenneth D. Miller III
 Triangle Wave
 */
 
+#include "Wave.h"
+
 class OscillatorConfig;
 class OscillatorState;
 
 extern float OscillatorTriangle(OscillatorConfig const &config, OscillatorState &state, float step);
+
+// triangle block renderers
+extern WaveRenderTable triangle_render;
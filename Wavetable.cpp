@@ -0,0 +1,79 @@
+/*
+MINI VIRTUAL ANALOG SYNTHESIZER
+Copyright 2014 Kenneth D. Miller III
+
+Mipmapped Bandlimited Wavetables
+*/
+#include "StdAfx.h"
+
+#include "Wavetable.h"
+#include "Math.h"
+
+// pi in double precision
+static double const PI = 3.14159265358979323846;
+
+Wavetable *wavetable_sawtooth;
+Wavetable *wavetable_triangle;
+
+// build a wavetable from its sine series
+void BuildWavetable(Wavetable &table, WavetableHarmonic harmonic)
+{
+	double re[WAVETABLE_SIZE];
+	double im[WAVETABLE_SIZE];
+
+	for (int l = 0; l < WAVETABLE_LEVELS; ++l)
+	{
+		// harmonics that fit in this level
+		int const harmonics = Max(int(WAVETABLE_HARMONICS * pow(2.0, -double(l) / WAVETABLE_LEVELS_PER_OCTAVE)), 1);
+
+		// sine series as a spectrum
+		for (int i = 0; i < WAVETABLE_SIZE; ++i)
+		{
+			re[i] = 0.0;
+			im[i] = 0.0;
+		}
+		for (int k = 1; k <= harmonics; ++k)
+		{
+			double const amplitude = harmonic(k);
+			im[k] = -0.5 * amplitude;
+			im[WAVETABLE_SIZE - k] = 0.5 * amplitude;
+		}
+
+		// synthesize one cycle
+		FourierTransform(re, im, WAVETABLE_SIZE, true);
+		for (int i = 0; i < WAVETABLE_SIZE; ++i)
+			table.level[l][i] = float(re[i] * WAVETABLE_SIZE);
+		table.level[l][WAVETABLE_SIZE] = table.level[l][0];
+	}
+}
+
+// sawtooth harmonics
+// 2/pi sum k=1..infinity sin(k*2*pi*phase)/k
+static float SawtoothHarmonic(int const k)
+{
+	return float(2.0 / (PI * k));
+}
+
+// triangle harmonics
+// 8/pi**2 sum k=0..infinity (-1)**k sin((2*k+1)*2*pi*phase)/(2*k+1)**2
+static float TriangleHarmonic(int const k)
+{
+	if (!(k & 1))
+		return 0.0f;
+	return float(((k & 2) ? -8.0 : 8.0) / (PI * PI * k * k));
+}
+
+// build the wavetables
+void InitWavetables()
+{
+	if (!wavetable_sawtooth)
+	{
+		wavetable_sawtooth = static_cast<Wavetable *>(malloc(sizeof(Wavetable)));
+		BuildWavetable(*wavetable_sawtooth, SawtoothHarmonic);
+	}
+	if (!wavetable_triangle)
+	{
+		wavetable_triangle = static_cast<Wavetable *>(malloc(sizeof(Wavetable)));
+		BuildWavetable(*wavetable_triangle, TriangleHarmonic);
+	}
+}
@@ -0,0 +1,120 @@
+#pragma once
+/*
+MINI VIRTUAL ANALOG SYNTHESIZER
+Copyright 2014 Kenneth D. Miller III
+
+Mipmapped Bandlimited Wavetables
+*/
+
+#include "Oscillator.h"
+#include "Math.h"
+
+// Each wavetable holds one cycle of a wave at a series of mip levels spaced
+// a third of an octave apart, each keeping only the harmonics that stay
+// below Nyquist for every phase step the level is used for.  A block picks
+// the two levels around its phase step and crossfades them, so the per-sample
+// cost is two table reads and a lerp per level with no edge handling.  The
+// third-octave spacing keeps everything up to 0.4 of the sample rate at the
+// bottom of each level's range.
+
+// samples per cycle
+// (plus one guard sample so interpolation never wraps)
+#define WAVETABLE_SIZE 2048
+
+// most harmonics in the first level
+#define WAVETABLE_HARMONICS (WAVETABLE_SIZE / 2 - 1)
+
+// mip levels per octave and in total
+// (the last level holds only the fundamental)
+#define WAVETABLE_LEVELS_PER_OCTAVE 3
+#define WAVETABLE_LEVELS 31
+
+// bandlimited wavetable
+struct Wavetable
+{
+	float level[WAVETABLE_LEVELS][WAVETABLE_SIZE + 1];
+};
+
+// harmonic amplitude function for building a wavetable
+// (returns the sine amplitude of harmonic k)
+typedef float(*WavetableHarmonic)(int const k);
+
+// build a wavetable from its sine series
+extern void BuildWavetable(Wavetable &table, WavetableHarmonic harmonic);
+
+// sawtooth and triangle wavetables
+// (the pulse wave is the difference of two sawtooth lookups)
+extern Wavetable *wavetable_sawtooth;
+extern Wavetable *wavetable_triangle;
+
+// build the wavetables
+extern void InitWavetables();
+
+// pair of mip levels for a phase step
+struct WavetableLevels
+{
+	float const *lower;	// more harmonics
+	float const *upper;	// fewer harmonics
+	float fade;			// crossfade toward upper
+};
+
+// get the mip levels for a phase step
+static __forceinline WavetableLevels GetWavetableLevels(Wavetable const &table, float const delta)
+{
+	// third-octave position of the phase step relative to the first level's limit
+	float const position = WAVETABLE_LEVELS_PER_OCTAVE * FastLog2(Max(2.0f * WAVETABLE_HARMONICS * delta, FLT_MIN));
+	int level = FloorInt(position) + 1;
+	float fade = position - float(level - 1);
+	if (level <= 0)
+		level = 0, fade = 0.0f;
+	else if (level >= WAVETABLE_LEVELS - 1)
+		level = WAVETABLE_LEVELS - 1, fade = 0.0f;
+	WavetableLevels const levels = { table.level[level], table.level[Min(level + 1, WAVETABLE_LEVELS - 1)], fade };
+	return levels;
+}
+
+// look up a wavetable value at a phase in [0, 1)
+static __forceinline float LookupWavetable(WavetableLevels const &levels, float const phase)
+{
+	float const t = phase * WAVETABLE_SIZE;
+	int const i = Min(FloorInt(t), WAVETABLE_SIZE - 1);
+	float const f = t - float(i);
+	float const lower = levels.lower[i] + (levels.lower[i + 1] - levels.lower[i]) * f;
+	float const upper = levels.upper[i] + (levels.upper[i + 1] - levels.upper[i]) * f;
+	return lower + (upper - lower) * levels.fade;
+}
+
+// render a block of wavetable oscillator output and add it to the buffer
+// (hard sync is not supported)
+// EVALUATE: wave value from the mip levels for the block
+// limit: highest phase step the wave can represent (the wave is silent above it)
+template <float EVALUATE(OscillatorConfig const &config, WavetableLevels const &levels, float phase)>
+__forceinline void RenderWavetable(OscillatorConfig const &config, OscillatorState &state, Wavetable const &table, float const delta, float const limit, float buffer[], size_t const count)
+{
+	// work on a local copy of the state
+	OscillatorState local(state);
+
+	if (delta > limit)
+	{
+		// only advance the phase
+		for (size_t i = 0; i < count; ++i)
+			local.Advance<false>(config, delta);
+	}
+	else
+	{
+		// mip levels for the block
+		WavetableLevels const levels = GetWavetableLevels(table, delta);
+
+		// ramp amplitude across the block
+		float amplitude = config.amplitude_begin;
+		float const amplitude_step = (config.amplitude - config.amplitude_begin) / count;
+		for (size_t i = 0; i < count; ++i)
+		{
+			amplitude += amplitude_step;
+			buffer[i] += amplitude * EVALUATE(config, levels, local.phase);
+			local.Advance<false>(config, delta);
+		}
+	}
+
+	state = local;
+}
@@ -0,0 +1,285 @@
+/*
+MINI VIRTUAL ANALOG SYNTHESIZER
+Copyright 2014 Kenneth D. Miller III
+
+Headless Offline Renderer
+*/
+#include "StdAfx.h"
+
+#include <chrono>
+#include <thread>
+
+#include "Math.h"
+#include "Voice.h"
+#include "Control.h"
+#include "Wave.h"
+#include "Filter.h"
+#include "OscillatorNote.h"
+#include "Amplifier.h"
+#include "Render.h"
+#include "RenderPool.h"
+#include "EventQueue.h"
+#include "Patch.h"
+#include "Snapshot.h"
+#include "MidiFile.h"
+#include "WaveFile.h"
+#include "TableGen.h"
+
+// render a standard midi file through the synthesizer without any audio
+// hardware, writing the result to a wave file and reporting throughput
+
+// command-line usage
+static void Usage()
+{
+	fprintf(stderr,
+		"usage: offline [options] input.mid output.wav\n"
+		"       offline -check\n"
+		"       offline -tables <file>\n"
+		"  -check            measure fast math accuracy, check the render pool, and exit\n"
+		"  -tables <file>    write the precomputed lookup tables as C++ source and exit\n"
+		"  -patch <file>     load a patch file\n"
+		"  -rate <hz>        output sample rate (default 48000)\n"
+		"  -format <f>       output sample format: float or pcm24 (default float)\n"
+		"  -block <samples>  render block size (default 480)\n"
+		"  -tail <seconds>   longest release tail after the last event (default 10)\n"
+		"  -threads <count>  render worker threads (default 0)\n"
+		"  -voices <count>   polyphony (default 16, up to 256)\n"
+		"  -control <samples> samples per control update (default 32, 4 to 64)\n"
+		"  -silence <dBFS>   retire falling voices below this level (default -96)\n"
+		);
+}
+
+// check for any sounding voices
+static bool AnyVoiceActive()
+{
+	for (int v = 0; v < voice_count; ++v)
+	{
+		if (amp_env_state[v].state != EnvelopeState::OFF)
+			return true;
+	}
+	return false;
+}
+
+// measure fast math accuracy against the C library
+// and check the render pool with more worker threads than cores
+static int Check()
+{
+	float exp2_cents, log2_cents;
+	MeasureFastMath(exp2_cents, log2_cents);
+	printf("FastExp2 error:   %.5f cents (limit %.2f)\n", exp2_cents, FAST_EXP2_CENTS);
+	printf("FastLog2 error:   %.5f cents (limit %.2f)\n", log2_cents, FAST_LOG2_CENTS);
+
+	int const threads = Min(2 * Max(int(std::thread::hardware_concurrency()), 1) + 1, RenderPool::MAX_THREADS);
+	int const jobs = 20000;
+	int const failed = RenderPool::Check(threads, jobs);
+	printf("render pool:      %d of %d jobs failed (%d threads)\n", failed, jobs, threads);
+
+	bool const pass = exp2_cents <= FAST_EXP2_CENTS && log2_cents <= FAST_LOG2_CENTS && failed == 0;
+	printf("%s\n", pass ? "pass" : "FAIL");
+	return pass ? 0 : 1;
+}
+
+// offline render state
+struct Offline
+{
+	WaveFile::Writer writer;
+	float *buffer;
+	size_t block;
+	float step;
+	size_t samples;
+	double seconds;
+
+	// render count samples in blocks and write them out
+	bool Advance(size_t count)
+	{
+		while (count > 0)
+		{
+			size_t const n = Min(count, block);
+
+			// only the render itself counts toward throughput
+			std::chrono::high_resolution_clock::time_point const start = std::chrono::high_resolution_clock::now();
+			Render(buffer, n, step);
+			std::chrono::high_resolution_clock::time_point const finish = std::chrono::high_resolution_clock::now();
+			seconds += std::chrono::duration<double>(finish - start).count();
+
+			if (!writer.Write(buffer, n))
+				return false;
+			samples += n;
+			count -= n;
+		}
+		return true;
+	}
+};
+
+int main(int argc, char **argv)
+{
+	char const *patch = NULL;
+	char const *input = NULL;
+	char const *output = NULL;
+	int rate = 48000;
+	WaveFile::Format format = WaveFile::FORMAT_FLOAT32;
+	int block = 480;
+	double tail = 10.0;
+	int threads = 0;
+	int voices = DEFAULT_VOICES;
+	int control = DEFAULT_CONTROL_SAMPLES;
+	float silence = DEFAULT_SILENCE_DB;
+
+	// parse the command line
+	for (int i = 1; i < argc; ++i)
+	{
+		char const *arg = argv[i];
+		if (!strcmp(arg, "-check"))
+			return Check();
+		else if (!strcmp(arg, "-tables") && i + 1 < argc)
+			return WriteTables(argv[++i]) ? 0 : 1;
+		else if (arg[0] == '-' && i + 1 < argc)
+		{
+			char const *value = argv[++i];
+			if (!strcmp(arg, "-patch"))
+				patch = value;
+			else if (!strcmp(arg, "-rate"))
+				rate = atoi(value);
+			else if (!strcmp(arg, "-block"))
+				block = atoi(value);
+			else if (!strcmp(arg, "-tail"))
+				tail = atof(value);
+			else if (!strcmp(arg, "-threads"))
+				threads = atoi(value);
+			else if (!strcmp(arg, "-voices"))
+				voices = atoi(value);
+			else if (!strcmp(arg, "-control"))
+				control = atoi(value);
+			else if (!strcmp(arg, "-silence"))
+				silence = float(atof(value));
+			else if (!strcmp(arg, "-format") && !strcmp(value, "float"))
+				format = WaveFile::FORMAT_FLOAT32;
+			else if (!strcmp(arg, "-format") && !strcmp(value, "pcm24"))
+				format = WaveFile::FORMAT_PCM24;
+			else
+			{
+				Usage();
+				return 1;
+			}
+		}
+		else if (!input)
+			input = arg;
+		else if (!output)
+			output = arg;
+		else
+		{
+			Usage();
+			return 1;
+		}
+	}
+	if (!input || !output || rate <= 0 || block <= 0 || tail < 0 || threads < 0 || threads > RenderPool::MAX_THREADS || voices < 1 || voices > MAX_VOICES || control < int(MIN_CONTROL_SAMPLES) || control > int(MAX_CONTROL_SAMPLES))
+	{
+		Usage();
+		return 1;
+	}
+
+	// set the control update rate
+	control_samples = size_t(control);
+
+	// set the silence threshold
+	silence_db = silence;
+
+	// allocate the voice pool
+	if (!InitVoices(voices))
+	{
+		fprintf(stderr, "cannot allocate %d voices\n", voices);
+		return 1;
+	}
+
+	// initialize waves
+	InitWave();
+
+	// initialize filter tuning
+	InitFilter();
+
+	// enable the first oscillator
+	osc_config[0].enable = true;
+
+	// reset all controllers
+	Control::ResetAll();
+
+	// load the patch
+	if (patch && !Patch::Load(patch))
+		return 1;
+
+	// hand the patch to the renderer
+	InitSnapshots();
+
+	// load the midi file
+	Midi::File::Event *events;
+	int const count = Midi::File::Load(input, events);
+	if (count < 0)
+	{
+		fprintf(stderr, "%s: cannot read midi file\n", input);
+		return 1;
+	}
+
+	// open the output
+	Offline offline;
+	offline.buffer = static_cast<float *>(malloc(block * 2 * sizeof(float)));
+	offline.block = block;
+	offline.step = 1.0f / rate;
+	offline.samples = 0;
+	offline.seconds = 0.0;
+	if (!offline.buffer || !offline.writer.Open(output, rate, 2, format))
+	{
+		fprintf(stderr, "%s: cannot write wave file\n", output);
+		free(events);
+		return 1;
+	}
+
+	// start render worker threads
+	RenderPool::Init(threads, RENDER_CHUNK_SAMPLES);
+
+	// render up to each event then apply it
+	bool ok = true;
+	for (int i = 0; ok && i < count; ++i)
+	{
+		size_t const target = size_t(events[i].time * rate + 0.5);
+		if (target > offline.samples)
+			ok = offline.Advance(target - offline.samples);
+		EventQueue::Apply(events[i].status, events[i].data1, events[i].data2);
+	}
+	free(events);
+
+	// render the release tail
+	size_t const tail_end = offline.samples + size_t(tail * rate);
+	while (ok && offline.samples < tail_end && AnyVoiceActive())
+	{
+		ok = offline.Advance(Min(size_t(block), tail_end - offline.samples));
+	}
+
+	// stop render worker threads
+	RenderPool::Done();
+
+	ok = offline.writer.Close() && ok;
+	free(offline.buffer);
+	DoneSnapshots();
+	DoneVoices();
+	if (!ok)
+	{
+		fprintf(stderr, "%s: error writing wave file\n", output);
+		return 1;
+	}
+
+	// report throughput
+	double const duration = double(offline.samples) / rate;
+	printf("events:           %d\n", count);
+	printf("threads:          %d\n", threads);
+	printf("voices:           %d\n", voices);
+	printf("control samples:  %d\n", control);
+	printf("silence:          %.1f dBFS\n", silence);
+	printf("samples:          %u (%.3fs)\n", unsigned(offline.samples), duration);
+	printf("render time:      %.3fs\n", offline.seconds);
+	if (offline.seconds > 0.0)
+	{
+		printf("samples/second:   %.0f\n", offline.samples / offline.seconds);
+		printf("real-time factor: %.4f (%.1fx real time)\n", offline.seconds / duration, duration / offline.seconds);
+	}
+	return 0;
+}
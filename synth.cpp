@@ -12,7 +12,11 @@ Copyright 2014 Kenneth D. Miller III
 #include "Keys.h"
 #include "Voice.h"
 #include "Midi.h"
+#include "EventQueue.h"
 #include "Control.h"
+#include "Render.h"
+#include "RenderPool.h"
+#include "Snapshot.h"
 
 #include "PolyBLEP.h"
 #include "Oscillator.h"
@@ -45,187 +49,16 @@ void Error(char const *text)
 // window title
 char const title_text[] = ">>> MINI VIRTUAL ANALOG SYNTHESIZER";
 
-// output scale factor
-float output_scale = 0.25f;	// 0.25f;
-
-static size_t const BLOCK_UPDATE_SAMPLES = 16;
-
-// apply low-frequency oscillator value
-static void ApplyLFO(float lfo)
-{
-	// compute shared oscillator values
-	for (int o = 0; o < NUM_OSCILLATORS; ++o)
-	{
-		osc_config[o].Modulate(lfo);
-	}
-
-	// set up sync phases
-	for (int o = 1; o < NUM_OSCILLATORS; ++o)
-	{
-		if (osc_config[o].sync_enable)
-			osc_config[o].sync_phase = osc_config[o].frequency / osc_config[0].frequency;
-	}
-}
-
 DWORD CALLBACK WriteStream(HSTREAM handle, float *buffer, DWORD length, void *user)
 {
-	// get active voices
-	int index[VOICES];
-	int active = 0;
-	for (int v = 0; v < VOICES; v++)
-	{
-		if (amp_env_state[v].state != EnvelopeState::OFF)
-		{
-			index[active++] = v;
-		}
-	}
-
 	// number of samples
 	size_t count = length / (2 * sizeof(buffer[0]));
 
-	// key frequencies
-	float osc_key_freq[VOICES][NUM_OSCILLATORS];
-	float flt_key_freq[VOICES];
-
-	// for each active voice...
-	for (int i = 0; i < active; ++i)
-	{
-		// get the voice index
-		int const v = index[i];
-
-		// compute oscillator key frequency
-		for (int o = 0; o < NUM_OSCILLATORS; ++o)
-		{
-			osc_key_freq[v][o] = NoteFrequency(voice_note[v], osc_config[o].key_follow);
-		}
-
-		// compute filter key frequency
-		flt_key_freq[v] = NoteFrequency(voice_note[v], flt_config.key_follow);
-	}
-
-	// low-frequency oscillator value
-	// (updated every BLOCK_UPDATE_SAMPLES)
-	float lfo = 0;
-
-	if (active == 0)
-	{
-		// clear buffer
-		memset(buffer, 0, length);
-
-		// get low-frequency oscillator value
-		if (lfo_config.enable)
-			lfo = lfo_state.Update(lfo_config, float(count) / info.freq);
-
-		// apply low-frequency oscillator
-		ApplyLFO(lfo);
-
-		return length;
-	}
-
-	// flush denormals
-	unsigned int prev;
-	_controlfp_s(&prev, _DN_FLUSH, _MCW_DN);
-
-	// time step per output sample
-	float const step = 1.0f / info.freq;
-
-	// time step per output block
-	float const block_step = step * BLOCK_UPDATE_SAMPLES;
+	// place events that arrived since the last request within this buffer
+	EventQueue::SetTime(timeGetTime());
 
-	// if the low-frequency oscillator is off...
-	if (!lfo_config.enable)
-	{
-		ApplyLFO(0);
-	}
-
-	// for each output sample...
-	for (size_t c = 0; c < count; ++c)
-	{
-		if ((c & (BLOCK_UPDATE_SAMPLES - 1)) == 0)
-		{
-			// apply low-frequency oscillator
-			if (lfo_config.enable)
-			{
-				// get low-frequency oscillator value
-				lfo = lfo_state.Update(lfo_config, block_step);
-
-				// apply low-frequency oscillator
-				ApplyLFO(lfo);
-			}
-		}
-
-		// accumulated sample value
-		float sample = 0.0f;
-
-		// for each active voice...
-		for (int i = 0; i < active; ++i)
-		{
-			// get the voice index
-			int const v = index[i];
-
-			// update volume envelope generator
-			float const amp_env_amplitude = amp_env_state[v].Update(amp_env_config, step);
-
-			// if the envelope generator finished...
-			if (amp_env_state[v].state == EnvelopeState::OFF)
-			{
-				// remove from active oscillators
-				--active;
-				index[i] = index[active];
-				--i;
-				continue;
-			}
-
-			// key velocity
-			float const key_vel = voice_vel[v] / 64.0f;
-
-			// update oscillators
-			// (assume key follow)
-			float osc_value = 0.0f;
-			for (int o = 0; o < NUM_OSCILLATORS; ++o)
-			{
-				if (!osc_config[o].enable)
-					continue;
-				float const key_step = osc_key_freq[v][o] * step;
-				if (osc_config[o].sub_osc_mode && osc_config[o].sub_osc_amplitude)
-					osc_value += osc_config[o].sub_osc_amplitude * SubOscillator(osc_config[o], osc_state[v][o], key_step);
-				osc_value += osc_state[v][o].Update(osc_config[o], key_step);
-			}
-
-			// update filter
-			if (flt_config.enable)
-			{
-				if ((c & (BLOCK_UPDATE_SAMPLES - 1)) == 0)
-				{
-					// update filter envelope generator
-					float const flt_env_amplitude = flt_env_state[v].Update(flt_env_config, block_step);
-
-					// compute cutoff frequency
-					float const cutoff = flt_key_freq[v] * flt_config.GetCutoff(lfo, flt_env_amplitude, key_vel);
-
-					// set up the filter
-					flt_state[v].Setup(cutoff, flt_config.resonance, step);
-				}
-
-				// get filtered oscillator value
-				osc_value = flt_state[v].Update(flt_config, osc_value);
-			}
-
-			// apply amplifier level and accumulate result
-			sample += osc_value * amp_config.GetLevel(amp_env_amplitude, key_vel);
-		}
-
-		// left and right channels are the same
-		//short const output = short(Clamp(int(sample * output_scale * 32768), SHRT_MIN, SHRT_MAX));
-		//short const output = short(FastTanh(sample * output_scale) * 32767);
-		//float const output = FastTanh(sample * output_scale);
-		float const output = sample * output_scale;
-		*buffer++ = output;
-		*buffer++ = output;
-	}
-
-	// restore denormal
-	_controlfp_s(&prev, prev, _MCW_DN);
+	// render output samples
+	Render(buffer, count, 1.0f / info.freq);
 
 	return length;
 }
@@ -262,12 +95,22 @@ void PrintAntialias(HANDLE hOut)
 {
 	COORD const pos = { 61, SPECTRUM_HEIGHT + 2 };
 	PrintConsole(hOut, pos, "F12 Antialias:");
-	if (use_antialias)
+	if (use_antialias && antialias_method == ANTIALIAS_MINBLEP)
+		PrintConsoleWithAttribute(hOut, { pos.X + 15, pos.Y }, FOREGROUND_GREEN | FOREGROUND_BLUE, "MIN");
+	else if (use_antialias && antialias_method == ANTIALIAS_WAVETABLE)
+		PrintConsoleWithAttribute(hOut, { pos.X + 15, pos.Y }, FOREGROUND_GREEN | FOREGROUND_RED, "TBL");
+	else if (use_antialias)
 		PrintConsoleWithAttribute(hOut, { pos.X + 15, pos.Y }, FOREGROUND_GREEN, " ON");
 	else
 		PrintConsoleWithAttribute(hOut, { pos.X + 15, pos.Y }, FOREGROUND_RED,   "OFF");
 }
 
+// queue a note message from the computer keyboard for the render thread
+void KeyboardNote(unsigned char const status, int const note)
+{
+	EventQueue::Push(EventQueue::SOURCE_KEYBOARD, timeGetTime(), status, (unsigned char)(note), 64);
+}
+
 
 void __cdecl main(int argc, char **argv)
 {
@@ -344,20 +187,44 @@ void __cdecl main(int argc, char **argv)
 	// set channel to apply effects
 	fx_channel = stream;
 
-#ifdef BANDLIMITED_SAWTOOTH
-	// initialize bandlimited sawtooth tables
-	InitSawtooth();
-#endif
-
 	// initialize waves
 	InitWave();
 
+	// initialize filter tuning
+	InitFilter();
+
 	// enable the first oscillator
 	osc_config[0].enable = true;
 
 	// reset all controllers
 	Control::ResetAll();
 
+	// get startup settings
+	// (synth -threads <count> -voices <count> -control <samples> -silence <dBFS>)
+	int threads = 0;
+	int voices = DEFAULT_VOICES;
+	for (int i = 1; i + 1 < argc; ++i)
+	{
+		if (!strcmp(argv[i], "-threads"))
+			threads = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-voices"))
+			voices = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-control"))
+			control_samples = Clamp<size_t>(atoi(argv[++i]), MIN_CONTROL_SAMPLES, MAX_CONTROL_SAMPLES);
+		else if (!strcmp(argv[i], "-silence"))
+			silence_db = float(atof(argv[++i]));
+	}
+
+	// allocate the voice pool
+	if (!InitVoices(voices))
+		Error("Can't allocate voices\n");
+
+	// start render worker threads
+	RenderPool::Init(threads, RENDER_CHUNK_SAMPLES);
+
+	// hand the initial patch to the renderer
+	InitSnapshots();
+
 	// start playing the audio stream
 	BASS_ChannelPlay(stream, FALSE);
 
@@ -386,7 +253,7 @@ void __cdecl main(int argc, char **argv)
 
 	// initialize to middle c
 	note_most_recent = 60;
-	voice_note[voice_most_recent] = unsigned char(note_most_recent);
+	voice_note[voice_most_recent] = (unsigned char)(note_most_recent);
 
 	DisplaySpectrumAnalyzer displaySpectrumAnalyzer;
 	DisplayKeyVolumeEnvelope displayKeyVolumeEnvelope;
@@ -451,13 +318,13 @@ void __cdecl main(int argc, char **argv)
 							for (int k = 0; k < KEYS; ++k)
 							{
 								if (key_down[k])
-									NoteOff(k + keyboard_octave * 12);
+									KeyboardNote(0x80, k + keyboard_octave * 12);
 							}
 							--keyboard_octave;
 							for (int k = 0; k < KEYS; ++k)
 							{
 								if (key_down[k])
-									NoteOn(k + keyboard_octave * 12);
+									KeyboardNote(0x90, k + keyboard_octave * 12);
 							}
 							PrintKeyOctave(hOut);
 						}
@@ -469,20 +336,28 @@ void __cdecl main(int argc, char **argv)
 							for (int k = 0; k < KEYS; ++k)
 							{
 								if (key_down[k])
-									NoteOff(k + keyboard_octave * 12);
+									KeyboardNote(0x80, k + keyboard_octave * 12);
 							}
 							++keyboard_octave;
 							for (int k = 0; k < KEYS; ++k)
 							{
 								if (key_down[k])
-									NoteOn(k + keyboard_octave * 12);
+									KeyboardNote(0x90, k + keyboard_octave * 12);
 							}
 							PrintKeyOctave(hOut);
 						}
 					}
 					else if (code == VK_F12)
 					{
-						use_antialias = !use_antialias;
+						// cycle off, PolyBLEP, minBLEP, wavetable
+						if (!use_antialias)
+							SetAntialias(ANTIALIAS_POLYBLEP);
+						else if (antialias_method == ANTIALIAS_POLYBLEP)
+							SetAntialias(ANTIALIAS_MINBLEP);
+						else if (antialias_method == ANTIALIAS_MINBLEP)
+							SetAntialias(ANTIALIAS_WAVETABLE);
+						else
+							SetAntialias(ANTIALIAS_NONE);
 						PrintAntialias(hOut);
 					}
 					else if (code >= VK_F1 && code < VK_F10)
@@ -530,12 +405,12 @@ void __cdecl main(int argc, char **argv)
 							if (down)
 							{
 								// note on
-								NoteOn(k + keyboard_octave * 12);
+								KeyboardNote(0x90, k + keyboard_octave * 12);
 							}
 							else
 							{
 								// note off
-								NoteOff(k + keyboard_octave * 12);
+								KeyboardNote(0x80, k + keyboard_octave * 12);
 							}
 						}
 						break;
@@ -551,6 +426,15 @@ void __cdecl main(int argc, char **argv)
 			}
 		}
 
+		// publish patch changes to the render thread
+		PublishSnapshot();
+
+		// apply the low-frequency oscillator to the edited oscillators for the displays
+		// (the render thread modulates its own copy)
+		float const lfo = lfo_config.enable ? lfo_state.Update(lfo_config, 0.0f) : 0.0f;
+		for (int o = 0; o < NUM_OSCILLATORS; ++o)
+			osc_config[o].Modulate(lfo);
+
 		// center frequency of the zeroth semitone band
 		// (one octave down from the lowest key)
 		float const freq_min = powf(2, float(keyboard_octave - 6)) * middle_c_frequency;
@@ -602,4 +486,13 @@ void __cdecl main(int argc, char **argv)
 	Clear(hOut);
 
 	BASS_Free();
+
+	// stop render worker threads
+	RenderPool::Done();
+
+	// free the patch snapshots
+	DoneSnapshots();
+
+	// free the voice pool
+	DoneVoices();
 }